@@ -0,0 +1,373 @@
+#include "batch.h"
+
+#include "maze.h"
+#include "solve.h"
+#include "spsc.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Pipelined batch solver.
+ * Reader threads read whole input files ahead of time, the calling thread
+ * parses and solves them, and a writer thread stores the results, so disk
+ * reads, solving and disk writes of different mazes overlap. Reader k owns
+ * the inputs k, k + readers, ... and a bounded SPSC queue to the solve stage,
+ * which takes them round-robin and so keeps input order without any lock.
+ * A full queue stalls its producer, which caps the mazes in memory at about
+ * readers * (depth + 1) + depth + 2.
+ *
+ * A stage whose thread cannot be started runs inline on the calling thread,
+ * so the pipeline degrades to the plain sequential loop instead of failing.
+ */
+
+#define BATCH_READ_CHUNK 4096
+
+enum batch_status
+{
+    BATCH_OK,
+    BATCH_CANNOT_OPEN,
+    BATCH_INVALID,
+    BATCH_NO_SOLUTION,
+    BATCH_CANNOT_CREATE,
+    BATCH_NO_MEMORY,
+    BATCH_DUPLICATE_NAME,
+};
+
+static const char *const status_messages[] = {
+    "OK",
+    "Cannot open input file.",
+    "Invalid maze.",
+    "No solution found.",
+    "Cannot create output file.",
+    "Memory allocation failed.",
+    "Output file name already used by an earlier input.",
+};
+
+struct batch_job
+{
+    const char *input_path;
+    char *data; // file contents, freed once parsed
+    size_t size;
+    char *output; // solved maze as maze_print writes it
+    size_t output_size;
+    enum batch_status status;
+};
+
+struct reader
+{
+    struct batch_job *jobs;
+    size_t count;
+    size_t first;
+    size_t step;
+    struct spsc_queue queue;
+    bool running;
+    double busy_seconds;
+};
+
+struct writer
+{
+    const char *output_dir;
+    struct spsc_queue queue;
+    bool running;
+    size_t failures;
+    double busy_seconds;
+};
+
+// reads the whole file, regular files in one allocation with the kernel told to read ahead
+static void read_job(struct batch_job *job)
+{
+    if (job->status != BATCH_OK) {
+        return;
+    }
+    int fd = open(job->input_path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        job->status = BATCH_CANNOT_OPEN;
+        return;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // one spare byte lets the read that sees EOF land without growing the buffer
+    size_t capacity = st.st_size > 0 ? (size_t) st.st_size + 1 : BATCH_READ_CHUNK;
+    job->data = (char *) malloc(capacity);
+    job->size = 0;
+    while (job->data != NULL) {
+        if (job->size == capacity) {
+            char *grown = (char *) realloc(job->data, capacity * 2);
+            if (grown == NULL) {
+                free(job->data);
+                job->data = NULL;
+                break;
+            }
+            job->data = grown;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, job->data + job->size, capacity - job->size);
+        if (n < 0) {
+            free(job->data);
+            job->data = NULL;
+            job->status = BATCH_CANNOT_OPEN;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        job->size += (size_t) n;
+    }
+    if (job->data == NULL && job->status == BATCH_OK) {
+        job->status = BATCH_NO_MEMORY;
+    }
+    close(fd);
+}
+
+// the solve mode's steps through solution_create, the output goes to memory
+static void solve_job(struct batch_job *job)
+{
+    if (job->status != BATCH_OK) {
+        return;
+    }
+    // fmemopen rejects empty buffers, an empty file is no maze anyway
+    FILE *file = job->size > 0 ? fmemopen(job->data, job->size, "r") : NULL;
+    if (file == NULL) {
+        job->status = job->size > 0 ? BATCH_NO_MEMORY : BATCH_INVALID;
+        free(job->data);
+        job->data = NULL;
+        return;
+    }
+    struct solution solution;
+    enum solve_status status = solution_create(&solution, file);
+    fclose(file);
+    free(job->data);
+    job->data = NULL;
+    if (status != SOLVE_OK) {
+        job->status = status == SOLVE_INVALID ? BATCH_INVALID : BATCH_NO_SOLUTION;
+        return;
+    }
+
+    FILE *output = open_memstream(&job->output, &job->output_size);
+    if (output == NULL) {
+        job->status = BATCH_NO_MEMORY;
+    } else {
+        bool printed = solution_print(&solution, output);
+        if (fclose(output) != 0 || !printed) {
+            job->status = BATCH_NO_MEMORY;
+        }
+    }
+    solution_destroy(&solution);
+}
+
+static const char *output_name(const char *input_path)
+{
+    const char *slash = strrchr(input_path, '/');
+    return slash != NULL ? slash + 1 : input_path;
+}
+
+static int compare_output_names(const void *a, const void *b)
+{
+    const struct batch_job *x = *(const struct batch_job *const *) a;
+    const struct batch_job *y = *(const struct batch_job *const *) b;
+    int order = strcmp(output_name(x->input_path), output_name(y->input_path));
+    if (order != 0) {
+        return order;
+    }
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Outputs are named after the input's file name only, so two inputs with the
+ * same name would overwrite each other. Every input after the first one with
+ * a given name fails instead. Returns false on allocation failure.
+ */
+static bool reject_duplicate_names(struct batch_job *jobs, size_t count)
+{
+    if (count < 2) {
+        return true;
+    }
+    struct batch_job **sorted = (struct batch_job **) malloc(count * sizeof(struct batch_job *));
+    if (sorted == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        sorted[i] = &jobs[i];
+    }
+    // ties keep input order, so the earliest input of a name is the one kept
+    qsort(sorted, count, sizeof(struct batch_job *), compare_output_names);
+    for (size_t i = 1; i < count; i++) {
+        if (strcmp(output_name(sorted[i - 1]->input_path), output_name(sorted[i]->input_path)) == 0) {
+            sorted[i]->status = BATCH_DUPLICATE_NAME;
+        }
+    }
+    free(sorted);
+    return true;
+}
+
+// stores the result under output_dir with the input's file name
+static void write_job(struct writer *writer, struct batch_job *job)
+{
+    if (job->status == BATCH_OK) {
+        const char *name = output_name(job->input_path);
+        size_t length = strlen(writer->output_dir) + strlen(name) + 2;
+        char *path = (char *) malloc(length);
+        FILE *file = NULL;
+        if (path != NULL) {
+            snprintf(path, length, "%s/%s", writer->output_dir, name);
+            file = fopen(path, "w");
+        }
+        if (file == NULL) {
+            job->status = BATCH_CANNOT_CREATE;
+        } else {
+            size_t written = fwrite(job->output, 1, job->output_size, file);
+            if (fclose(file) != 0 || written != job->output_size) {
+                job->status = BATCH_CANNOT_CREATE;
+            }
+        }
+        free(path);
+    }
+    if (job->status != BATCH_OK) {
+        fprintf(stderr, "Error: %s: %s\n", job->input_path, status_messages[job->status]);
+        writer->failures++;
+    }
+    free(job->output);
+    job->output = NULL;
+}
+
+static void *reader_main(void *arg)
+{
+    struct reader *reader = (struct reader *) arg;
+    for (size_t i = reader->first; i < reader->count; i += reader->step) {
+        double start = maze_now_seconds();
+        read_job(&reader->jobs[i]);
+        reader->busy_seconds += maze_now_seconds() - start;
+        spsc_push(&reader->queue, &reader->jobs[i]);
+    }
+    return NULL;
+}
+
+// pops jobs until the NULL that ends the batch
+static void *writer_main(void *arg)
+{
+    struct writer *writer = (struct writer *) arg;
+    struct batch_job *job;
+    while ((job = (struct batch_job *) spsc_pop(&writer->queue)) != NULL) {
+        double start = maze_now_seconds();
+        write_job(writer, job);
+        writer->busy_seconds += maze_now_seconds() - start;
+    }
+    return NULL;
+}
+
+/*
+ * Solves every input and writes it to output_dir under its own file name.
+ * Failures are reported on stderr per maze and counted in stats. Returns
+ * false if any maze failed or the pipeline could not be set up.
+ */
+bool batch_run(char *const *inputs, size_t count, const char *output_dir, const struct batch_options *options, struct batch_stats *stats)
+{
+    assert(inputs != NULL || count == 0);
+    assert(output_dir != NULL);
+    assert(options != NULL);
+    assert(stats != NULL);
+
+    memset(stats, 0, sizeof(*stats));
+    double wall_start = maze_now_seconds();
+    size_t num_readers = options->readers == 0 ? 1 : options->readers;
+    size_t depth = options->depth == 0 ? 1 : options->depth;
+    if (num_readers > count) {
+        num_readers = count > 0 ? count : 1;
+    }
+
+    struct batch_job *jobs = (struct batch_job *) calloc(count > 0 ? count : 1, sizeof(struct batch_job));
+    struct reader *readers = (struct reader *) calloc(num_readers, sizeof(struct reader));
+    pthread_t *threads = (pthread_t *) malloc((num_readers + 1) * sizeof(pthread_t));
+    struct writer writer = { .output_dir = output_dir, .running = false, .failures = 0, .busy_seconds = 0 };
+    bool ok = jobs != NULL && readers != NULL && threads != NULL && spsc_init(&writer.queue, depth);
+    size_t queues = 0;
+    for (; ok && queues < num_readers; queues++) {
+        ok = spsc_init(&readers[queues].queue, depth);
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        jobs[i].input_path = inputs[i];
+        jobs[i].status = BATCH_OK;
+    }
+    ok = ok && reject_duplicate_names(jobs, count);
+    if (!ok) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        for (size_t i = 0; readers != NULL && i < queues; i++) {
+            spsc_destroy(&readers[i].queue);
+        }
+        spsc_destroy(&writer.queue);
+        free(jobs);
+        free(readers);
+        free(threads);
+        return false;
+    }
+
+    for (size_t r = 0; r < num_readers; r++) {
+        readers[r].jobs = jobs;
+        readers[r].count = count;
+        readers[r].first = r;
+        readers[r].step = num_readers;
+        readers[r].running = pthread_create(&threads[r], NULL, reader_main, &readers[r]) == 0;
+    }
+    writer.running = pthread_create(&threads[num_readers], NULL, writer_main, &writer) == 0;
+
+    // solve stage on the calling thread, in input order
+    for (size_t i = 0; i < count; i++) {
+        struct reader *reader = &readers[i % num_readers];
+        struct batch_job *job;
+        if (reader->running) {
+            job = (struct batch_job *) spsc_pop(&reader->queue);
+        } else {
+            double start = maze_now_seconds();
+            job = &jobs[i];
+            read_job(job);
+            reader->busy_seconds += maze_now_seconds() - start;
+        }
+
+        double start = maze_now_seconds();
+        solve_job(job);
+        stats->solve_seconds += maze_now_seconds() - start;
+
+        if (writer.running) {
+            spsc_push(&writer.queue, job);
+        } else {
+            start = maze_now_seconds();
+            write_job(&writer, job);
+            writer.busy_seconds += maze_now_seconds() - start;
+        }
+    }
+    if (writer.running) {
+        spsc_push(&writer.queue, NULL);
+        pthread_join(threads[num_readers], NULL);
+    }
+
+    for (size_t r = 0; r < num_readers; r++) {
+        if (readers[r].running) {
+            pthread_join(threads[r], NULL);
+        }
+        stats->read_seconds += readers[r].busy_seconds;
+        stats->read_stalls += readers[r].queue.full_waits;
+        stats->solve_stalls += readers[r].queue.empty_waits;
+        spsc_destroy(&readers[r].queue);
+    }
+    stats->write_seconds = writer.busy_seconds;
+    stats->write_stalls = writer.queue.full_waits;
+    stats->mazes = count;
+    stats->failures = writer.failures;
+    spsc_destroy(&writer.queue);
+    free(jobs);
+    free(readers);
+    free(threads);
+    stats->wall_seconds = maze_now_seconds() - wall_start;
+    return stats->failures == 0;
+}
@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BATCH_DEFAULT_READERS 2
+#define BATCH_DEFAULT_DEPTH 4
+
+struct batch_options
+{
+    size_t readers; // read-ahead threads, each with its own queue to the solve stage
+    size_t depth;   // slots per queue, bounds the mazes held in memory
+};
+
+struct batch_stats
+{
+    size_t mazes;
+    size_t failures;
+    double read_seconds;  // summed busy time of the reader threads
+    double solve_seconds;
+    double write_seconds;
+    double wall_seconds;
+    size_t read_stalls;   // readers held back by a full queue
+    size_t solve_stalls;  // solve stage waiting for input
+    size_t write_stalls;  // solve stage held back by the writer
+};
+
+bool batch_run(char *const *inputs, size_t count, const char *output_dir, const struct batch_options *options, struct batch_stats *stats);
+
+#endif // BATCH_H
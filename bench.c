@@ -0,0 +1,308 @@
+#include "bench.h"
+
+#include "ccl.h"
+#include "gen.h"
+#include "kernel.h"
+#include "path.h"
+#include "stripes.h"
+#include "maze.h"
+#include "tiled.h"
+#include "validate.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+/*
+ * Benchmarks for the grid engines.
+ * Each run generates tall, wide and square mazes of roughly the same number
+ * of cells, loads them through maze_create and times every engine on the
+ * same input (best of BENCH_REPEATS).
+ */
+
+#define BENCH_REPEATS 3
+#define BENCH_MAX_THREADS 8
+
+struct bench_shape
+{
+    const char *name;
+    size_t aspect_w; // width : height ratio of the generated maze
+    size_t aspect_h;
+};
+
+static const struct bench_shape shapes[] = {
+    { "tall", 1, 16 },
+    { "wide", 16, 1 },
+    { "square", 1, 1 },
+};
+
+static bool load_generated(struct maze *maze, size_t cols, size_t rows, uint64_t seed)
+{
+    // generate into memory and read back through the normal loader
+    char *text = NULL;
+    size_t text_size = 0;
+    FILE *stream = open_memstream(&text, &text_size);
+    if (stream == NULL) {
+        return false;
+    }
+    bool ok = maze_generate(stream, cols, rows, seed);
+    fclose(stream);
+    if (!ok) {
+        free(text);
+        return false;
+    }
+    stream = fmemopen(text, text_size, "r");
+    if (stream == NULL) {
+        free(text);
+        return false;
+    }
+    ok = maze_create(maze, stream);
+    fclose(stream);
+    free(text);
+    if (!ok) {
+        maze_destroy(maze);
+    }
+    return ok;
+}
+
+static double time_kernel(struct maze *maze, size_t index_bytes, size_t *length)
+{
+    double best = INFINITY;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double start = maze_now_seconds();
+        if (!kernel_solve_length(maze, index_bytes, length)) {
+            *length = 0;
+        }
+        double elapsed = maze_now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+// marks the path into the maze, so it runs after the engines that read tiles
+static double time_solve_maze(struct maze *maze, bool reference)
+{
+    double best = INFINITY;
+    bool saved = maze->options.reference_checks;
+    maze->options.reference_checks = reference;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double start = maze_now_seconds();
+        volatile bool ok = solve_maze(maze);
+        (void) ok;
+        double elapsed = maze_now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    maze->options.reference_checks = saved;
+    return best;
+}
+
+static double time_validate(struct maze *maze, size_t threads, bool *valid)
+{
+    double best = INFINITY;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        struct validation validation;
+        struct components components;
+        double start = maze_now_seconds();
+        *valid = validate_stripes(&validation, &components, maze, threads);
+        double elapsed = maze_now_seconds() - start;
+        if (*valid) {
+            *valid = validation.bad_row == maze->height && !validation.alone_column
+                    && components.num_wall_components <= 1;
+            components_destroy(&components);
+        }
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+// the sequential checks validate_stripes replaces
+static double time_validate_reference(struct maze *maze)
+{
+    double best = INFINITY;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double start = maze_now_seconds();
+        volatile bool ok = is_connected(maze) && col_alone_wall(maze);
+        (void) ok;
+        double elapsed = maze_now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+struct path_job
+{
+    const struct maze *maze;
+    struct maze_path path;
+    bool found;
+};
+
+static void *path_worker(void *arg)
+{
+    struct path_job *job = (struct path_job *) arg;
+    job->found = maze_solve_path(job->maze, &job->path);
+    return NULL;
+}
+
+// checkpoint lookups must agree with walking the moves one by one
+static bool path_consistent(const struct maze_path *path)
+{
+    bool consistent = true;
+    struct position pos = path->start;
+    struct position adjacent_positions[4];
+    for (size_t i = 0; i <= path->length; i++) {
+        if (i % 97 == 0 || i == path->length) {
+            struct position lookup = maze_path_position(path, i);
+            consistent &= lookup.x == pos.x && lookup.y == pos.y;
+        }
+        if (i < path->length) {
+            maze_get_adjacent_positions(pos, adjacent_positions);
+            pos = adjacent_positions[maze_path_move(path, i)];
+        }
+    }
+    return consistent && pos.x == path->end.x && pos.y == path->end.y;
+}
+
+// 'threads' queries on the same maze at once, it is shared read-only
+static double time_path_queries(const struct maze *maze, size_t threads, size_t expected, bool *agree)
+{
+    struct path_job jobs[BENCH_MAX_THREADS];
+    double best = INFINITY;
+    *agree = true;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        for (size_t i = 0; i < threads; i++) {
+            jobs[i].maze = maze;
+        }
+        double start = maze_now_seconds();
+        stripes_run(jobs, sizeof(struct path_job), threads, path_worker);
+        double elapsed = maze_now_seconds() - start;
+        for (size_t i = 0; i < threads; i++) {
+            *agree &= jobs[i].found && jobs[i].path.length == expected && path_consistent(&jobs[i].path);
+            if (jobs[i].found) {
+                maze_path_destroy(&jobs[i].path);
+            }
+        }
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+static double time_col_check(const struct tiled_grid *grid)
+{
+    double best = INFINITY;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double start = maze_now_seconds();
+        volatile bool ok = tiled_col_alone_wall(grid);
+        (void) ok;
+        double elapsed = maze_now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+static double time_col_check_rows(struct maze *maze)
+{
+    double best = INFINITY;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double start = maze_now_seconds();
+        volatile bool ok = col_alone_wall(maze);
+        (void) ok;
+        double elapsed = maze_now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+/*
+ * Runs all shapes with about 'cells' characters each and prints one line
+ * per shape and engine. Returns false if an input could not be built or the
+ * engines disagree on the path length.
+ */
+bool bench_run(size_t cells, FILE *output_file)
+{
+    assert(output_file != NULL);
+    bool agree = true;
+
+    fprintf(output_file, "%-8s %-22s %12s %10s\n", "shape", "engine", "size", "ms");
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        // text is (2 * cols + 1) x (2 * rows + 1) characters
+        double unit = sqrt((double) cells / (4.0 * shapes[s].aspect_w * shapes[s].aspect_h));
+        size_t cols = (size_t) (unit * shapes[s].aspect_w) + 1;
+        size_t rows = (size_t) (unit * shapes[s].aspect_h) + 1;
+
+        struct maze maze;
+        if (!load_generated(&maze, cols, rows, s + 1)) {
+            fprintf(stderr, "Error: Cannot build %s benchmark maze.\n", shapes[s].name);
+            return false;
+        }
+
+        struct tiled_grid block_grid;
+        if (!tiled_grid_create(&block_grid, &maze, TILED_BLOCK_SHIFT, TILED_BLOCK_SHIFT)) {
+            maze_destroy(&maze);
+            return false;
+        }
+
+        char size[32];
+        snprintf(size, sizeof(size), "%zux%zu", maze.width, maze.height);
+        // the path length every kernel width and path query must agree on
+        size_t length = 0;
+        if (!kernel_solve_length(&maze, KERNEL_AUTO_INDEX, &length)) {
+            fprintf(stderr, "Error: %s benchmark maze has no path.\n", shapes[s].name);
+            agree = false;
+        }
+        fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, "col_alone_wall", size,
+                time_col_check_rows(&maze) * 1e3);
+        fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, "col check tiled 64x64", size,
+                time_col_check(&block_grid) * 1e3);
+
+        // striped validation against the sequential connectivity and column checks
+        fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, "is_connected+col", size,
+                time_validate_reference(&maze) * 1e3);
+        for (size_t threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+            char engine[32];
+            bool valid = false;
+            snprintf(engine, sizeof(engine), "validate %zu thread%s", threads, threads == 1 ? "" : "s");
+            fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, engine, size,
+                    time_validate(&maze, threads, &valid) * 1e3);
+            if (!valid) {
+                fprintf(stderr, "Error: %s validation with %zu threads rejected the maze.\n", shapes[s].name, threads);
+                agree = false;
+            }
+        }
+
+        // specialized kernels, every index width that can address the maze
+        size_t index_bytes[3] = { 2, 4, 8 };
+        for (int i = 0; i < 3; i++) {
+            if (index_bytes[i] < kernel_index_bytes(&maze)) {
+                continue;
+            }
+            char engine[32];
+            size_t kernel_length = 0;
+            snprintf(engine, sizeof(engine), "bfs kernel u%zu", index_bytes[i] * 8);
+            fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, engine, size,
+                    time_kernel(&maze, index_bytes[i], &kernel_length) * 1e3);
+            if (kernel_length != length) {
+                fprintf(stderr, "Error: %s kernel path length differs (%zu vs %zu).\n", shapes[s].name, kernel_length, length);
+                agree = false;
+            }
+        }
+        for (size_t threads = 1; threads <= BENCH_MAX_THREADS; threads *= 4) {
+            char engine[32];
+            bool consistent;
+            snprintf(engine, sizeof(engine), "path query x%zu", threads);
+            fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, engine, size,
+                    time_path_queries(&maze, threads, length, &consistent) * 1e3);
+            if (!consistent) {
+                fprintf(stderr, "Error: %s path queries on %zu threads disagree.\n", shapes[s].name, threads);
+                agree = false;
+            }
+        }
+        fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, "solve_maze reference", size,
+                time_solve_maze(&maze, true) * 1e3);
+        fprintf(output_file, "%-8s %-22s %12s %10.2f\n", shapes[s].name, "solve_maze kernel", size,
+                time_solve_maze(&maze, false) * 1e3);
+
+        tiled_grid_destroy(&block_grid);
+        maze_destroy(&maze);
+    }
+    return agree;
+}
@@ -0,0 +1,10 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+bool bench_run(size_t cells, FILE *output_file);
+
+#endif // BENCH_H
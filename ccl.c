@@ -0,0 +1,182 @@
+#include "ccl.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/*
+ * Two-pass connected-component labeling with union-find, run stripe by
+ * stripe from validate_stripes (validate.c) on horizontal stripes of the
+ * grid. Pass one unions every cell with its left and upper neighbour inside
+ * its own stripe, always linking the larger root below the smaller one. A
+ * short sequential merge then unions the rows on both sides of each stripe
+ * border. Pass two rewrites every label to
+ * its root; a concurrent reader of another stripe sees either the old parent
+ * or the final root, and both lead to the same root, so this pass needs no
+ * locking either, only relaxed atomic loads and stores of the links.
+ */
+
+static uint32_t find_root(const uint32_t *labels, uint32_t label)
+{
+    while (labels[label - 1] != label) {
+        label = labels[label - 1];
+    }
+    return label;
+}
+
+static void unite(uint32_t *labels, uint32_t a, uint32_t b)
+{
+    a = find_root(labels, a);
+    b = find_root(labels, b);
+    if (a < b) {
+        labels[b - 1] = a;
+    } else if (b < a) {
+        labels[a - 1] = b;
+    }
+}
+
+// links cell i of a class to its left and upper neighbours of the same class
+static void label_cell(uint32_t *labels, size_t i, bool member, bool left, bool up, size_t width)
+{
+    if (!member) {
+        labels[i] = 0;
+        return;
+    }
+    // a fresh cell hangs straight below its left neighbour's root, the smaller index
+    labels[i] = left && labels[i - 1] != 0 ? find_root(labels, labels[i - 1]) : (uint32_t) (i + 1);
+    if (up && labels[i - width] != 0 && labels[i - width] != labels[i]) {
+        unite(labels, labels[i], labels[i - width]);
+    }
+}
+
+// pass two reads links another stripe may be rewriting, any value it sees is still an ancestor
+static uint32_t find_root_shared(const uint32_t *labels, uint32_t label)
+{
+    uint32_t parent;
+    while ((parent = __atomic_load_n(&labels[label - 1], __ATOMIC_RELAXED)) != label) {
+        label = parent;
+    }
+    return label;
+}
+
+static size_t flatten_rows(uint32_t *labels, size_t begin, size_t end)
+{
+    size_t roots = 0;
+    for (size_t i = begin; i < end; i++) {
+        if (labels[i] == 0) {
+            continue;
+        }
+        if (labels[i] == i + 1) {
+            roots++;
+        } else {
+            __atomic_store_n(&labels[i], find_root_shared(labels, labels[i]), __ATOMIC_RELAXED);
+        }
+    }
+    return roots;
+}
+
+/*
+ * Allocates the label arrays for the padded maze. Returns false on
+ * allocation failure or if the grid has too many cells for 32-bit labels.
+ */
+bool components_init(struct components *components, struct maze *maze)
+{
+    assert(components != NULL);
+    assert(maze != NULL);
+
+    size_t cells = maze->width * maze->height;
+    components->width = maze->width;
+    components->height = maze->height;
+    components->wall_labels = NULL;
+    components->open_labels = NULL;
+    components->num_wall_components = 0;
+    components->num_open_components = 0;
+    components->entrance_label = 0;
+    components->exit_label = 0;
+    if (cells > COMPONENTS_MAX_CELLS) {
+        return false;
+    }
+    components->wall_labels = (uint32_t *) malloc(cells * sizeof(uint32_t));
+    components->open_labels = (uint32_t *) malloc(cells * sizeof(uint32_t));
+    if (components->wall_labels == NULL || components->open_labels == NULL) {
+        components_destroy(components);
+        return false;
+    }
+    return true;
+}
+
+// pass one for rows [y_begin, y_end), safe to run on disjoint stripes in parallel
+void components_label_rows(struct components *components, struct maze *maze, size_t y_begin, size_t y_end)
+{
+    assert(components != NULL);
+    size_t width = components->width;
+    for (size_t y = y_begin; y < y_end; y++) {
+        // both classes in one pass, open is the maze_is_walkable rule read a row at a time
+        const struct tile *tiles = maze->tiles[y];
+        size_t open_end = maze->line_lengths[y] < width ? maze->line_lengths[y] : width;
+        for (size_t x = 0; x < width; x++) {
+            size_t i = y * width + x;
+            char value = tiles[x].value;
+            label_cell(components->wall_labels, i, value == '#' || value == 'X', x > 0, y > y_begin, width);
+            label_cell(components->open_labels, i, x < open_end && value != '#', x > 0, y > y_begin, width);
+        }
+    }
+}
+
+// merge step: unions row y with row y - 1 once both stripes are labeled
+void components_stitch_row(struct components *components, size_t y)
+{
+    assert(components != NULL);
+    assert(y > 0);
+    size_t width = components->width;
+    for (size_t x = 0; x < width; x++) {
+        size_t cell = y * width + x;
+        if (components->wall_labels[cell] != 0 && components->wall_labels[cell - width] != 0) {
+            unite(components->wall_labels, (uint32_t) (cell + 1), (uint32_t) (cell + 1 - width));
+        }
+        if (components->open_labels[cell] != 0 && components->open_labels[cell - width] != 0) {
+            unite(components->open_labels, (uint32_t) (cell + 1), (uint32_t) (cell + 1 - width));
+        }
+    }
+}
+
+// pass two for rows [y_begin, y_end), reports the roots found there
+void components_flatten_rows(struct components *components, size_t y_begin, size_t y_end, size_t *wall_roots, size_t *open_roots)
+{
+    assert(components != NULL);
+    size_t width = components->width;
+    *wall_roots = flatten_rows(components->wall_labels, y_begin * width, y_end * width);
+    *open_roots = flatten_rows(components->open_labels, y_begin * width, y_end * width);
+}
+
+static uint32_t open_label(const struct components *components, struct position pos)
+{
+    if (pos.x < 0 || (size_t) pos.x >= components->width || pos.y < 0 || (size_t) pos.y >= components->height) {
+        return 0;
+    }
+    return components->open_labels[(size_t) pos.y * components->width + (size_t) pos.x];
+}
+
+// keeps the two labels solve asks about and frees both label arrays, validation needs nothing else
+void components_keep_doors(struct components *components, struct position entrance, struct position exit)
+{
+    assert(components != NULL);
+    components->entrance_label = open_label(components, entrance);
+    components->exit_label = open_label(components, exit);
+    components_destroy(components);
+}
+
+void components_destroy(struct components *components)
+{
+    assert(components != NULL);
+    free(components->wall_labels);
+    free(components->open_labels);
+    components->wall_labels = NULL;
+    components->open_labels = NULL;
+}
+
+// O(1) reachability: entrance and exit open and in the same open component
+bool components_connected(const struct components *components)
+{
+    assert(components != NULL);
+    return components->entrance_label != 0 && components->entrance_label == components->exit_label;
+}
@@ -0,0 +1,40 @@
+#ifndef CCL_H
+#define CCL_H
+
+#include "maze.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Labels are cell index + 1 of the component root, 0 means the cell is not
+ * part of that class. Cells count as walls when they hold '#' or 'X' (the
+ * is_connected rule) and as open when solve_maze may step on them. Only
+ * the counts and the open labels of the entrance and exit outlive labeling,
+ * both label arrays are freed once those are known.
+ */
+// labels are cell index + 1 in 32 bits, 0 stays free for non-members
+#define COMPONENTS_MAX_CELLS ((size_t) UINT32_MAX - 1)
+
+struct components
+{
+    size_t width;
+    size_t height;
+    uint32_t *wall_labels;
+    uint32_t *open_labels;
+    size_t num_wall_components;
+    size_t num_open_components;
+    uint32_t entrance_label; // 0 when the entrance is not an open cell
+    uint32_t exit_label;
+};
+
+bool components_init(struct components *components, struct maze *maze);
+void components_label_rows(struct components *components, struct maze *maze, size_t y_begin, size_t y_end);
+void components_stitch_row(struct components *components, size_t y);
+void components_flatten_rows(struct components *components, size_t y_begin, size_t y_end, size_t *wall_roots, size_t *open_roots);
+void components_keep_doors(struct components *components, struct position entrance, struct position exit);
+void components_destroy(struct components *components);
+bool components_connected(const struct components *components);
+
+#endif // CCL_H
@@ -0,0 +1,649 @@
+#include "compact.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+/*
+ * Compact solver for mazes too big for struct tile rows.
+ * maze_create keeps a struct tile per cell and solve_maze adds a visited flag
+ * and a parent position, about ten bytes per cell. Here the solver keeps one
+ * wall bit per cell, the two markers as positions and one row end per row;
+ * the BFS adds two bits per cell holding the distance modulo 3, which is
+ * enough to walk back from the exit because neighbouring cells differ by at
+ * most one step. The text itself is never held: it is read once to size the
+ * maze, once to build the bitmap and once more to print the solved maze.
+ * After the trace the wall bitmap is reused to mark the route.
+ *
+ * The bitmaps carry a ring of sentinel cells like the BFS kernels, so cell
+ * (x, y) is bit (y + 1) * (width + 2) + x + 1. The solver's arrays are
+ * counted as they are allocated so every phase reports what it held and its
+ * peak; line buffers of getline are left out.
+ *
+ * Terrain digits are rejected, weighted mazes need the Dial solver of the
+ * solve mode. Ties between shortest routes may resolve differently from
+ * solve_maze, the length is always the same.
+ */
+
+static const char *const status_messages[] = {
+    "OK",
+    "Cannot read input file.",
+    "Invalid maze.",
+    "No solution found.",
+    "Cannot write output file.",
+    "Memory allocation failed.",
+};
+
+static const char *const phase_names[] = {
+    "scan",
+    "load",
+    "validate",
+    "solve",
+    "trace",
+    "print",
+};
+
+struct compact_solver
+{
+    FILE *input_file;
+    size_t width;
+    size_t height;
+    uint64_t stride; // width + 2
+    uint64_t cells;  // including the sentinel ring
+    struct position markers[2]; // entrance and exit
+    size_t num_markers;
+    size_t leftmost;   // first printed column, like maze_print
+    size_t rule_row;   // first row breaking the one-wall row rule, height if none
+    uint32_t *row_ends; // count_Llength per row
+    uint64_t *bits;    // walls, blocked cells during the BFS, finally the route
+    size_t bits_bytes;
+    unsigned char *column_walls; // walls per column, saturating at 2
+    struct compact_stats *stats;
+    enum compact_phase phase;
+    double phase_start;
+    size_t held;
+};
+
+// frontier of one BFS level
+struct cell_list
+{
+    uint64_t *cells;
+    size_t count;
+    size_t capacity;
+};
+
+/* --- memory accounting --- */
+
+static void note_alloc(struct compact_solver *s, size_t bytes)
+{
+    struct compact_phase_stats *phase = &s->stats->phases[s->phase];
+    s->held += bytes;
+    if (s->held > phase->peak_bytes) {
+        phase->peak_bytes = s->held;
+    }
+    if (s->held > s->stats->peak_bytes) {
+        s->stats->peak_bytes = s->held;
+    }
+}
+
+static void *tracked_alloc(struct compact_solver *s, size_t bytes)
+{
+    void *memory = calloc(bytes > 0 ? bytes : 1, 1);
+    if (memory != NULL) {
+        note_alloc(s, bytes);
+    }
+    return memory;
+}
+
+static void tracked_free(struct compact_solver *s, void *memory, size_t bytes)
+{
+    if (memory != NULL) {
+        free(memory);
+        s->held -= bytes;
+    }
+}
+
+// closes the running phase and starts the next one, COMPACT_NUM_PHASES only closes
+static void enter_phase(struct compact_solver *s, enum compact_phase next)
+{
+    double now = maze_now_seconds();
+    struct compact_phase_stats *phase = &s->stats->phases[s->phase];
+    phase->seconds = now - s->phase_start;
+    phase->held_bytes = s->held;
+    if (next < COMPACT_NUM_PHASES) {
+        s->phase = next;
+        s->stats->phases[next].peak_bytes = s->held;
+    }
+    s->phase_start = now;
+}
+
+static bool list_push(struct compact_solver *s, struct cell_list *list, uint64_t cell)
+{
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity > 0 ? list->capacity * 2 : 1024;
+        uint64_t *cells = (uint64_t *) realloc(list->cells, capacity * sizeof(uint64_t));
+        if (cells == NULL) {
+            return false;
+        }
+        note_alloc(s, (capacity - list->capacity) * sizeof(uint64_t));
+        list->cells = cells;
+        list->capacity = capacity;
+    }
+    list->cells[list->count++] = cell;
+    return true;
+}
+
+static void list_free(struct compact_solver *s, struct cell_list *list)
+{
+    tracked_free(s, list->cells, list->capacity * sizeof(uint64_t));
+    list->cells = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/* --- bit grids --- */
+
+static bool bit_get(const uint64_t *bits, uint64_t i)
+{
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+static void bit_set(uint64_t *bits, uint64_t i)
+{
+    bits[i >> 6] |= (uint64_t) 1 << (i & 63);
+}
+
+// distance modulo 3 plus one, 0 while the cell is unreached
+static unsigned state_get(const uint64_t *state, uint64_t i)
+{
+    return (state[i >> 5] >> (2 * (i & 31))) & 3;
+}
+
+static void state_set(uint64_t *state, uint64_t i, unsigned value)
+{
+    state[i >> 5] |= (uint64_t) value << (2 * (i & 31));
+}
+
+static unsigned distance_code(size_t distance)
+{
+    return (unsigned) (distance % 3) + 1;
+}
+
+static uint64_t cell_index(const struct compact_solver *s, size_t x, size_t y)
+{
+    return ((uint64_t) y + 1) * s->stride + (uint64_t) x + 1;
+}
+
+/* --- text passes --- */
+
+// first pass: width from the rightmost wall, the markers and the character set
+static enum compact_status scan_text(struct compact_solver *s)
+{
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    size_t rightmost_wall = 0;
+    enum compact_status status = COMPACT_OK;
+
+    while (status == COMPACT_OK && (length = getline(&line, &line_capacity, s->input_file)) > 0) {
+        // positions are ints like in struct maze
+        if ((size_t) length > INT_MAX || s->height >= INT_MAX) {
+            fprintf(stderr, "maze too large\n");
+            status = COMPACT_INVALID;
+            break;
+        }
+        for (ssize_t x = 0; x < length; x++) {
+            char c = line[x];
+            if (c == '#') {
+                if ((size_t) x > rightmost_wall) {
+                    rightmost_wall = (size_t) x;
+                }
+            } else if (c == 'X') {
+                if (s->num_markers < 2) {
+                    s->markers[s->num_markers] = (struct position){ (int) x, (int) s->height };
+                }
+                s->num_markers++;
+            } else if (c >= '1' && c <= '9') {
+                fprintf(stderr, "terrain costs need the solve mode\n");
+                status = COMPACT_INVALID;
+                break;
+            } else if (c != ' ' && c != '\n') {
+                status = COMPACT_INVALID;
+                break;
+            }
+        }
+        s->height++;
+    }
+    free(line);
+    if (status == COMPACT_OK && ferror(s->input_file)) {
+        status = COMPACT_CANNOT_READ;
+    }
+    if (status == COMPACT_OK && s->num_markers != 2) {
+        fprintf(stderr, "invalid amount of entrances\n");
+        status = COMPACT_INVALID;
+    }
+    s->width = rightmost_wall + 1;
+    return status;
+}
+
+// second pass: wall bits, row ends, leftmost column and the row and column wall counts
+static enum compact_status load_bitmap(struct compact_solver *s)
+{
+    s->stride = (uint64_t) s->width + 2;
+    s->cells = s->stride * ((uint64_t) s->height + 2);
+    s->bits_bytes = (size_t) ((s->cells + 63) / 64 * sizeof(uint64_t));
+    s->bits = (uint64_t *) tracked_alloc(s, s->bits_bytes);
+    s->row_ends = (uint32_t *) tracked_alloc(s, s->height * sizeof(uint32_t));
+    s->column_walls = (unsigned char *) tracked_alloc(s, s->width);
+    if (s->bits == NULL || s->row_ends == NULL || s->column_walls == NULL) {
+        return COMPACT_NO_MEMORY;
+    }
+
+    rewind(s->input_file);
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    size_t y = 0;
+    s->leftmost = s->width;
+    s->rule_row = s->height;
+    for (; y < s->height && (length = getline(&line, &line_capacity, s->input_file)) > 0; y++) {
+        size_t limit = (size_t) length < s->width ? (size_t) length : s->width;
+        uint64_t base = cell_index(s, 0, y);
+        size_t walls = 0;
+        size_t markers = 0;
+        for (size_t x = 0; x < limit; x++) {
+            if (line[x] == '#') {
+                bit_set(s->bits, base + x);
+                walls++;
+                if (s->column_walls[x] < 2) {
+                    s->column_walls[x]++;
+                }
+            } else if (line[x] == 'X') {
+                markers++;
+            }
+        }
+        if (walls == 1 && markers != 1 && s->rule_row == s->height) {
+            s->rule_row = y;
+        }
+        for (size_t x = 0; x < limit && x < s->leftmost; x++) {
+            if (line[x] != ' ') {
+                s->leftmost = x;
+                break;
+            }
+        }
+        s->row_ends[y] = (uint32_t) maze_row_end(line, (size_t) length, s->width);
+    }
+    free(line);
+    return y == s->height ? COMPACT_OK : COMPACT_CANNOT_READ;
+}
+
+/* --- validation --- */
+
+static bool is_isolated_wall(const struct compact_solver *s, uint64_t cell)
+{
+    return !bit_get(s->bits, cell - 1) && !bit_get(s->bits, cell + 1)
+            && !bit_get(s->bits, cell - s->stride) && !bit_get(s->bits, cell + s->stride);
+}
+
+// same rule as is_valid_entrance, the sentinel ring stands in for the bounds checks
+static bool is_door(const struct compact_solver *s, struct position marker)
+{
+    // right of the last wall there is never a wall on the right
+    if ((size_t) marker.x >= s->width) {
+        return false;
+    }
+    uint64_t cell = cell_index(s, (size_t) marker.x, (size_t) marker.y);
+    bool left = bit_get(s->bits, cell - 1);
+    bool right = bit_get(s->bits, cell + 1);
+    bool up = bit_get(s->bits, cell - s->stride);
+    bool down = bit_get(s->bits, cell + s->stride);
+    return (left && right && !up && !down) || (up && down && !left && !right);
+}
+
+static size_t count_walls(const struct compact_solver *s)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < s->bits_bytes / sizeof(uint64_t); i++) {
+        count += (size_t) __builtin_popcountll(s->bits[i]);
+    }
+    return count;
+}
+
+// BFS over walls and markers with one visited bit per cell
+static enum compact_status check_connected(struct compact_solver *s, bool *connected)
+{
+    uint64_t doors[2] = { cell_index(s, (size_t) s->markers[0].x, (size_t) s->markers[0].y),
+                          cell_index(s, (size_t) s->markers[1].x, (size_t) s->markers[1].y) };
+    int64_t steps[4] = { -(int64_t) s->stride, 1, (int64_t) s->stride, -1 };
+    size_t total = count_walls(s) + 2;
+    size_t reached = 1;
+    uint64_t *visited = (uint64_t *) tracked_alloc(s, s->bits_bytes);
+    struct cell_list current = { NULL, 0, 0 };
+    struct cell_list next = { NULL, 0, 0 };
+    bool ok = visited != NULL && list_push(s, &current, doors[0]);
+    if (ok) {
+        bit_set(visited, doors[0]);
+    }
+
+    while (ok && current.count > 0) {
+        next.count = 0;
+        for (size_t i = 0; ok && i < current.count; i++) {
+            for (int k = 0; ok && k < 4; k++) {
+                uint64_t n = current.cells[i] + (uint64_t) steps[k];
+                bool wall = bit_get(s->bits, n) || n == doors[0] || n == doors[1];
+                if (wall && !bit_get(visited, n)) {
+                    bit_set(visited, n);
+                    reached++;
+                    ok = list_push(s, &next, n);
+                }
+            }
+        }
+        struct cell_list swap = current;
+        current = next;
+        next = swap;
+    }
+    list_free(s, &current);
+    list_free(s, &next);
+    tracked_free(s, visited, s->bits_bytes);
+    *connected = reached == total;
+    return ok ? COMPACT_OK : COMPACT_NO_MEMORY;
+}
+
+// the checks of is_valid in the same order, with the same messages
+static enum compact_status validate(struct compact_solver *s)
+{
+    size_t last_row = s->rule_row < s->height ? s->rule_row : s->height - 1;
+    for (size_t y = 0; y <= last_row; y++) {
+        uint64_t base = cell_index(s, 0, y);
+        for (size_t x = 0; x < s->width; x++) {
+            if (bit_get(s->bits, base + x) && is_isolated_wall(s, base + x)) {
+                return COMPACT_INVALID;
+            }
+        }
+    }
+    if (s->rule_row < s->height) {
+        fprintf(stderr, "only one line#\n");
+        return COMPACT_INVALID;
+    }
+    if (!is_door(s, s->markers[0])) {
+        fprintf(stderr, "invalid entrance\n");
+        return COMPACT_INVALID;
+    }
+    if (!is_door(s, s->markers[1])) {
+        fprintf(stderr, "invalid exit\n");
+        return COMPACT_INVALID;
+    }
+
+    bool connected;
+    enum compact_status status = check_connected(s, &connected);
+    if (status != COMPACT_OK) {
+        return status;
+    }
+    if (!connected) {
+        fprintf(stderr, "not connected\n");
+        return COMPACT_INVALID;
+    }
+
+    // both markers are inside the wall box once they passed as doors
+    for (size_t x = 0; x < s->width; x++) {
+        int column_markers = ((size_t) s->markers[0].x == x) + ((size_t) s->markers[1].x == x);
+        if (s->column_walls[x] == 1 && column_markers != 1) {
+            fprintf(stderr, "alone col\n");
+            return COMPACT_INVALID;
+        }
+    }
+    return COMPACT_OK;
+}
+
+/* --- search --- */
+
+// walls become blocked cells: add the sentinel ring and everything past each row end
+static void block_outside(struct compact_solver *s)
+{
+    for (uint64_t x = 0; x < s->stride; x++) {
+        bit_set(s->bits, x);
+        bit_set(s->bits, s->cells - s->stride + x);
+    }
+    for (size_t y = 0; y < s->height; y++) {
+        uint64_t base = cell_index(s, 0, y);
+        bit_set(s->bits, base - 1);
+        for (size_t x = s->row_ends[y]; x <= s->width; x++) {
+            bit_set(s->bits, base + x);
+        }
+    }
+}
+
+/*
+ * Level by level BFS from the entrance. Fills state with the distance codes
+ * and length with the distance of the exit; found stays false if the exit
+ * cannot be reached.
+ */
+static enum compact_status search(struct compact_solver *s, uint64_t *state, size_t *length, bool *found)
+{
+    uint64_t start = cell_index(s, (size_t) s->markers[0].x, (size_t) s->markers[0].y);
+    uint64_t target = cell_index(s, (size_t) s->markers[1].x, (size_t) s->markers[1].y);
+    int64_t steps[4] = { -(int64_t) s->stride, 1, (int64_t) s->stride, -1 };
+    struct cell_list current = { NULL, 0, 0 };
+    struct cell_list next = { NULL, 0, 0 };
+    bool ok = list_push(s, &current, start);
+    state_set(state, start, distance_code(0));
+    *found = false;
+
+    for (size_t distance = 1; ok && !*found && current.count > 0; distance++) {
+        unsigned code = distance_code(distance);
+        next.count = 0;
+        for (size_t i = 0; ok && !*found && i < current.count; i++) {
+            for (int k = 0; ok && !*found && k < 4; k++) {
+                uint64_t n = current.cells[i] + (uint64_t) steps[k];
+                if (bit_get(s->bits, n) || state_get(state, n) != 0) {
+                    continue;
+                }
+                state_set(state, n, code);
+                if (n == target) {
+                    *found = true;
+                    *length = distance;
+                } else {
+                    ok = list_push(s, &next, n);
+                }
+            }
+        }
+        struct cell_list swap = current;
+        current = next;
+        next = swap;
+    }
+    list_free(s, &current);
+    list_free(s, &next);
+    return ok ? COMPACT_OK : COMPACT_NO_MEMORY;
+}
+
+// steps back from the exit to a neighbour one step closer and records the move into path
+static enum compact_status trace(struct compact_solver *s, const uint64_t *state, struct maze_path *path)
+{
+    int64_t steps[4] = { -(int64_t) s->stride, 1, (int64_t) s->stride, -1 };
+    path->start = s->markers[0];
+    path->end = s->markers[1];
+    // the moves are freed by maze_path_destroy, so they are counted but not tracked_alloc'ed
+    size_t move_bytes = path->length / 4 + 1;
+    path->moves = (uint8_t *) calloc(move_bytes, 1);
+    path->checkpoints = NULL;
+    path->num_checkpoints = 0;
+    if (path->moves == NULL) {
+        return COMPACT_NO_MEMORY;
+    }
+    note_alloc(s, move_bytes);
+    uint64_t cell = cell_index(s, (size_t) s->markers[1].x, (size_t) s->markers[1].y);
+    for (size_t i = path->length; i-- > 0;) {
+        unsigned code = distance_code(i);
+        for (int k = 0; k < 4; k++) {
+            uint64_t previous = cell + (uint64_t) steps[k];
+            if (state_get(state, previous) == code) {
+                // the neighbour in direction k moved the opposite way
+                path->moves[i / 4] |= (uint8_t) (((k + 2) % 4) << (2 * (i % 4)));
+                cell = previous;
+                break;
+            }
+        }
+    }
+    if (!maze_path_add_checkpoints(path)) {
+        s->held -= move_bytes;
+        return COMPACT_NO_MEMORY;
+    }
+    note_alloc(s, path->num_checkpoints * sizeof(struct position));
+    return COMPACT_OK;
+}
+
+/* --- output --- */
+
+// third pass, prints like maze_print after solve_maze
+static enum compact_status print_solved(struct compact_solver *s, const struct maze_path *path, FILE *output_file)
+{
+    // the bitmap is free again, it now marks the route
+    int64_t steps[4] = { -(int64_t) s->stride, 1, (int64_t) s->stride, -1 };
+    memset(s->bits, 0, s->bits_bytes);
+    uint64_t cell = cell_index(s, (size_t) path->start.x, (size_t) path->start.y);
+    size_t x = (size_t) path->start.x;
+    size_t leftmost = x < s->leftmost ? x : s->leftmost;
+    bit_set(s->bits, cell);
+    for (size_t i = 0; i < path->length; i++) {
+        enum path_move move = maze_path_move(path, i);
+        cell += (uint64_t) steps[move];
+        x = move == PATH_RIGHT ? x + 1 : move == PATH_LEFT ? x - 1 : x;
+        bit_set(s->bits, cell);
+        if (x < leftmost) {
+            leftmost = x;
+        }
+    }
+
+    char *row = (char *) tracked_alloc(s, s->width + 1);
+    if (row == NULL) {
+        return COMPACT_NO_MEMORY;
+    }
+    rewind(s->input_file);
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    for (size_t y = 0; y < s->height && (length = getline(&line, &line_capacity, s->input_file)) > 0; y++) {
+        uint64_t base = cell_index(s, 0, y);
+        size_t used = 0;
+        for (size_t x = leftmost; x < s->row_ends[y]; x++) {
+            char c = x < (size_t) length ? line[x] : ' ';
+            if (bit_get(s->bits, base + x)) {
+                c = 'o';
+            }
+            if (c != '\n') {
+                row[used++] = c;
+            }
+        }
+        row[used++] = '\n';
+        fwrite(row, 1, used, output_file);
+    }
+    free(line);
+    tracked_free(s, row, s->width + 1);
+    return ferror(output_file) ? COMPACT_CANNOT_WRITE : COMPACT_OK;
+}
+
+/*
+ * Validates and solves the maze read from input_file, which is read up to
+ * three times and so must be seekable. With output_file set, the solved maze
+ * is written there in the same format as maze_print. With path set, it
+ * receives the route on success and needs maze_path_destroy. stats gets the
+ * memory held and peaked per phase.
+ */
+enum compact_status compact_solve(FILE *input_file, FILE *output_file, struct maze_path *path, struct compact_stats *stats)
+{
+    assert(input_file != NULL);
+    assert(stats != NULL);
+    memset(stats, 0, sizeof(*stats));
+    struct compact_solver s;
+    memset(&s, 0, sizeof(s));
+    s.input_file = input_file;
+    s.stats = stats;
+    s.phase = COMPACT_SCAN;
+    s.phase_start = maze_now_seconds();
+
+    enum compact_status status = scan_text(&s);
+    stats->width = s.width;
+    stats->height = s.height;
+    if (status == COMPACT_OK) {
+        enter_phase(&s, COMPACT_LOAD);
+        status = load_bitmap(&s);
+    }
+    if (status == COMPACT_OK) {
+        enter_phase(&s, COMPACT_VALIDATE);
+        status = validate(&s);
+        tracked_free(&s, s.column_walls, s.width);
+        s.column_walls = NULL;
+    }
+
+    struct maze_path route = { { 0, 0 }, { 0, 0 }, 0, NULL, NULL, 0 };
+    if (status == COMPACT_OK) {
+        enter_phase(&s, COMPACT_SOLVE);
+        block_outside(&s);
+        size_t state_bytes = (size_t) ((s.cells + 31) / 32 * sizeof(uint64_t));
+        uint64_t *state = (uint64_t *) tracked_alloc(&s, state_bytes);
+        bool found = false;
+        status = state != NULL ? search(&s, state, &route.length, &found) : COMPACT_NO_MEMORY;
+        if (status == COMPACT_OK && !found) {
+            status = COMPACT_NO_SOLUTION;
+        }
+        if (status == COMPACT_OK) {
+            enter_phase(&s, COMPACT_TRACE);
+            status = trace(&s, state, &route);
+        }
+        tracked_free(&s, state, state_bytes);
+    }
+    if (status == COMPACT_OK) {
+        stats->path_length = route.length;
+        if (output_file != NULL) {
+            enter_phase(&s, COMPACT_PRINT);
+            status = print_solved(&s, &route, output_file);
+        }
+    }
+    enter_phase(&s, COMPACT_NUM_PHASES);
+
+    tracked_free(&s, s.bits, s.bits_bytes);
+    tracked_free(&s, s.row_ends, s.height * sizeof(uint32_t));
+    if (status == COMPACT_OK && path != NULL) {
+        *path = route;
+    } else {
+        maze_path_destroy(&route);
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats->max_rss_kb = usage.ru_maxrss;
+    }
+    return status;
+}
+
+const char *compact_status_message(enum compact_status status)
+{
+    return status_messages[status];
+}
+
+static double megabytes(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+// one line per phase, then the overall peak against the cell count
+void compact_print_stats(const struct compact_stats *stats, FILE *output_file)
+{
+    assert(stats != NULL);
+    assert(output_file != NULL);
+    double cells = (double) stats->width * (double) stats->height;
+    fprintf(output_file, "Cells: %zu x %zu\n", stats->width, stats->height);
+    fprintf(output_file, "%-10s %12s %12s %10s\n", "Phase", "held MB", "peak MB", "ms");
+    for (int i = 0; i < COMPACT_NUM_PHASES; i++) {
+        const struct compact_phase_stats *phase = &stats->phases[i];
+        fprintf(output_file, "%-10s %12.2f %12.2f %10.2f\n", phase_names[i],
+                megabytes(phase->held_bytes), megabytes(phase->peak_bytes), phase->seconds * 1e3);
+    }
+    fprintf(output_file, "Peak solver memory: %.2f MB (%.3f bytes per cell)\n",
+            megabytes(stats->peak_bytes), cells > 0 ? stats->peak_bytes / cells : 0.0);
+    fprintf(output_file, "Peak RSS: %.2f MB\n", stats->max_rss_kb / 1024.0);
+}
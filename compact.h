@@ -0,0 +1,52 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include "path.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+enum compact_phase
+{
+    COMPACT_SCAN,     // size, characters and markers from a first text pass
+    COMPACT_LOAD,     // wall bitmap and row ends from a second text pass
+    COMPACT_VALIDATE, // maze_create rules on the bitmap
+    COMPACT_SOLVE,    // BFS with two bits of state per cell
+    COMPACT_TRACE,    // walk back from the exit into packed moves
+    COMPACT_PRINT,    // third text pass with the route drawn in
+    COMPACT_NUM_PHASES,
+};
+
+enum compact_status
+{
+    COMPACT_OK,
+    COMPACT_CANNOT_READ,
+    COMPACT_INVALID,
+    COMPACT_NO_SOLUTION,
+    COMPACT_CANNOT_WRITE,
+    COMPACT_NO_MEMORY,
+};
+
+struct compact_phase_stats
+{
+    size_t held_bytes; // solver memory still allocated when the phase ends
+    size_t peak_bytes; // most solver memory allocated at once during the phase
+    double seconds;
+};
+
+struct compact_stats
+{
+    size_t width;
+    size_t height;
+    size_t path_length; // steps from entrance to exit
+    struct compact_phase_stats phases[COMPACT_NUM_PHASES];
+    size_t peak_bytes;  // highest solver memory over all phases
+    long max_rss_kb;    // peak resident size of the whole process
+};
+
+enum compact_status compact_solve(FILE *input_file, FILE *output_file, struct maze_path *path, struct compact_stats *stats);
+const char *compact_status_message(enum compact_status status);
+void compact_print_stats(const struct compact_stats *stats, FILE *output_file);
+
+#endif // COMPACT_H
@@ -0,0 +1,122 @@
+#include "dial.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Weighted solver using Dial's algorithm.
+ * Terrain costs are small integers (1-9), so instead of a binary heap the
+ * tentative distances are kept in max_cost + 1 circular buckets. Every
+ * relaxation lands at most max_cost buckets ahead of the one being drained,
+ * which keeps the whole search at O(cells + max_cost * path_cost).
+ */
+
+struct bucket
+{
+    size_t *cells;
+    size_t count;
+    size_t capacity;
+};
+
+static bool bucket_push(struct bucket *b, size_t cell)
+{
+    if (b->count == b->capacity) {
+        size_t new_capacity = b->capacity == 0 ? 64 : b->capacity * 2;
+        size_t *new_cells = (size_t *) realloc(b->cells, new_capacity * sizeof(size_t));
+        if (new_cells == NULL) {
+            return false;
+        }
+        b->cells = new_cells;
+        b->capacity = new_capacity;
+    }
+    b->cells[b->count++] = cell;
+    return true;
+}
+
+/*
+ * Finds the cheapest path from entrance to exit, where stepping onto a tile
+ * costs tile.cost. Marks the path with 'o' like solve_maze and stores the
+ * summed cost in total_cost. Returns false if there is no path or memory
+ * runs out.
+ */
+bool solve_maze_weighted(struct maze *maze, size_t *total_cost)
+{
+    assert(maze != NULL);
+    assert(total_cost != NULL);
+
+    size_t cells = maze->height * maze->width;
+    size_t num_buckets = (size_t) maze->max_cost + 1;
+    size_t *dist = (size_t *) malloc(cells * sizeof(size_t));
+    unsigned char *came_from = (unsigned char *) malloc(cells);
+    struct bucket *buckets = (struct bucket *) calloc(num_buckets, sizeof(struct bucket));
+    bool ok = dist != NULL && came_from != NULL && buckets != NULL;
+    bool found = false;
+
+    if (ok) {
+        for (size_t i = 0; i < cells; i++) {
+            dist[i] = SIZE_MAX;
+        }
+        size_t start = (size_t) maze->entrance.y * maze->width + maze->entrance.x;
+        size_t target = (size_t) maze->exit.y * maze->width + maze->exit.x;
+        dist[start] = 0;
+        ok = bucket_push(&buckets[0], start);
+        size_t pending = 1;
+
+        for (size_t current = 0; ok && !found && pending > 0; current++) {
+            struct bucket *b = &buckets[current % num_buckets];
+            while (ok && b->count > 0) {
+                size_t cell = b->cells[--b->count];
+                pending--;
+                if (dist[cell] != current) {
+                    continue; // stale entry, a cheaper one was already settled
+                }
+                if (cell == target) {
+                    found = true;
+                    break;
+                }
+                struct position pos = { (int) (cell % maze->width), (int) (cell / maze->width) };
+                for (int d = 0; d < 4; d++) {
+                    struct position adj = { pos.x + maze_dx[d], pos.y + maze_dy[d] };
+                    if (!maze_is_walkable(maze, adj)) {
+                        continue;
+                    }
+                    size_t adj_cell = (size_t) adj.y * maze->width + adj.x;
+                    size_t next_dist = current + maze->tiles[adj.y][adj.x].cost;
+                    if (next_dist < dist[adj_cell]) {
+                        dist[adj_cell] = next_dist;
+                        came_from[adj_cell] = (unsigned char) d;
+                        if (!bucket_push(&buckets[next_dist % num_buckets], adj_cell)) {
+                            ok = false;
+                            break;
+                        }
+                        pending++;
+                    }
+                }
+            }
+        }
+
+        if (found) {
+            // Backtrack from exit to entrance to mark the path
+            *total_cost = dist[target];
+            struct position pos = maze->exit;
+            while (pos.x != maze->entrance.x || pos.y != maze->entrance.y) {
+                unsigned char d = came_from[(size_t) pos.y * maze->width + pos.x];
+                maze->tiles[pos.y][pos.x].value = 'o';
+                pos.x -= maze_dx[d];
+                pos.y -= maze_dy[d];
+            }
+            maze->tiles[pos.y][pos.x].value = 'o';
+        }
+    }
+
+    if (buckets != NULL) {
+        for (size_t i = 0; i < num_buckets; i++) {
+            free(buckets[i].cells);
+        }
+    }
+    free(buckets);
+    free(came_from);
+    free(dist);
+    return ok && found;
+}
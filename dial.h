@@ -0,0 +1,11 @@
+#ifndef DIAL_H
+#define DIAL_H
+
+#include "maze.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+bool solve_maze_weighted(struct maze *maze, size_t *total_cost);
+
+#endif // DIAL_H
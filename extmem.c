@@ -0,0 +1,1353 @@
+#include "extmem.h"
+
+#include "maze.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * External-memory solver for mazes that do not fit in RAM.
+ *
+ * The text maze is first streamed row by row into a binary walkability
+ * bitmap (header + one bit per cell, the same rule solve_maze uses) while
+ * the rules of is_valid are checked on a window of three rows. BFS then
+ * runs level by level in the style of Munagala and Ranade: the neighbours of
+ * level t are sorted externally, deduplicated and merged against levels t
+ * and t - 1, which is all the "visited" information an undirected BFS needs.
+ * Walkability of the surviving candidates is looked up through a page cache
+ * over the bitmap; candidates arrive sorted and consecutive levels are close
+ * together, so most lookups hit pages already read.
+ *
+ * Every sorted list (sort runs and BFS levels) is stored compressed as
+ * LEB128 varints of the gaps between consecutive cell indices. All levels
+ * stay on disk, and a backward pass over them rebuilds one shortest path,
+ * which is finally overlaid on a second streaming pass over the text.
+ */
+
+#define EXTMEM_MAGIC "MAZEBIN1"
+#define EXTMEM_HEADER_SIZE (8 + 6 * sizeof(uint64_t))
+#define EXTMEM_IO_BUFFER ((size_t) 64 << 10)
+#define EXTMEM_PAGE_SIZE ((size_t) 4 << 10)
+// buffers outside the split: level index tail, two level readers and the level writer, overlay stdio
+#define EXTMEM_FIXED_MEMORY (4 * EXTMEM_IO_BUFFER + 2 * (size_t) BUFSIZ)
+
+static const char *const status_messages[] = {
+    "OK",
+    "Cannot read input file.",
+    "Invalid maze.",
+    "The path overlay needs a text input.",
+    "No solution found.",
+    "Scratch or output file I/O failed.",
+};
+
+struct bin_header
+{
+    uint64_t width;
+    uint64_t height;
+    uint64_t entrance_x, entrance_y;
+    uint64_t exit_x, exit_y;
+};
+
+// scratch file whose most recently appended bytes stay in memory until the tail fills up
+struct xfile
+{
+    int fd;
+    unsigned char *tail;
+    size_t tail_capacity;
+    uint64_t tail_start; // file offset of tail[0], everything before it is on disk
+    size_t tail_used;
+    struct extmem_stats *stats;
+};
+
+// a sorted, gap-encoded list stored at [offset, offset + bytes) of a file
+struct run
+{
+    uint64_t offset;
+    uint64_t bytes;
+    uint64_t count;
+};
+
+struct run_writer
+{
+    struct xfile *file;
+    uint64_t start;
+    uint64_t offset;
+    unsigned char *buffer;
+    size_t used;
+    uint64_t last;
+    uint64_t count;
+    struct extmem_stats *stats;
+    bool failed;
+};
+
+struct run_reader
+{
+    struct xfile *file;
+    uint64_t offset;
+    uint64_t end;
+    unsigned char *buffer;
+    size_t capacity;
+    size_t pos;
+    size_t length;
+    uint64_t last;
+    uint64_t remaining;
+    struct extmem_stats *stats;
+    bool failed;
+};
+
+struct sorter
+{
+    uint64_t *values;      // in-memory run being filled
+    size_t used;
+    size_t capacity;
+    struct xfile *file;    // scratch file holding spilled runs
+    uint64_t end;
+    struct run *runs;
+    size_t num_runs;
+    size_t runs_capacity;
+    size_t fanin;          // runs merged at once, bounded by the memory cap
+    struct extmem_stats *stats;
+    bool failed;
+};
+
+struct merger
+{
+    struct run_reader *readers;
+    uint64_t *heads;
+    bool *live;
+    size_t count;
+    const uint64_t *memory; // used instead of readers when nothing was spilled
+    size_t memory_pos;
+    size_t memory_length;
+    bool has_last;
+    uint64_t last;
+};
+
+// direct-mapped cache of bitmap pages, consecutive levels mostly hit the same pages
+struct pager
+{
+    int fd;
+    uint64_t width;
+    uint64_t row_bytes;
+    unsigned char *pages;  // num_slots pages of EXTMEM_PAGE_SIZE bytes
+    uint64_t *page_numbers; // page held by each slot, UINT64_MAX when empty
+    size_t num_slots;
+    struct extmem_stats *stats;
+};
+
+/* --- raw file helpers --- */
+
+static bool write_all(int fd, const void *data, size_t size, uint64_t offset, struct extmem_stats *stats)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, (off_t) offset);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= (size_t) written;
+        offset += (uint64_t) written;
+        stats->bytes_written += (uint64_t) written;
+    }
+    return true;
+}
+
+static ssize_t read_some(int fd, void *data, size_t size, uint64_t offset, struct extmem_stats *stats)
+{
+    ssize_t got = pread(fd, data, size, (off_t) offset);
+    if (got > 0) {
+        stats->bytes_read += (uint64_t) got;
+    }
+    return got;
+}
+
+static int temp_open(const char *dir)
+{
+    // scratch files are unlinked right away so nothing is left behind
+    size_t length = strlen(dir) + sizeof("/maze-XXXXXX");
+    char *path = (char *) malloc(length);
+    if (path == NULL) {
+        return -1;
+    }
+    snprintf(path, length, "%s/maze-XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    free(path);
+    return fd;
+}
+
+static bool xfile_open(struct xfile *f, const char *dir, size_t tail_capacity, struct extmem_stats *stats)
+{
+    f->fd = temp_open(dir);
+    f->tail = tail_capacity > 0 ? (unsigned char *) malloc(tail_capacity) : NULL;
+    f->tail_capacity = f->tail != NULL ? tail_capacity : 0;
+    f->tail_start = 0;
+    f->tail_used = 0;
+    f->stats = stats;
+    return f->fd >= 0 && (tail_capacity == 0 || f->tail != NULL);
+}
+
+static bool xfile_flush(struct xfile *f)
+{
+    bool ok = f->tail_used == 0 || write_all(f->fd, f->tail, f->tail_used, f->tail_start, f->stats);
+    f->tail_start += f->tail_used;
+    f->tail_used = 0;
+    return ok;
+}
+
+// appends are buffered in the tail, anything else goes straight to disk
+static bool xfile_write(struct xfile *f, const void *data, size_t size, uint64_t offset)
+{
+    if (offset == f->tail_start + f->tail_used && size <= f->tail_capacity) {
+        if (f->tail_used + size > f->tail_capacity && !xfile_flush(f)) {
+            return false;
+        }
+        memcpy(f->tail + f->tail_used, data, size);
+        f->tail_used += size;
+        return true;
+    }
+    if (!xfile_flush(f) || !write_all(f->fd, data, size, offset, f->stats)) {
+        return false;
+    }
+    if (offset + size > f->tail_start) {
+        f->tail_start = offset + size;
+    }
+    return true;
+}
+
+static ssize_t xfile_read(struct xfile *f, void *data, size_t size, uint64_t offset)
+{
+    if (offset >= f->tail_start) {
+        uint64_t skip = offset - f->tail_start;
+        if (skip >= f->tail_used) {
+            return 0;
+        }
+        size_t available = f->tail_used - (size_t) skip;
+        size_t length = size < available ? size : available;
+        memcpy(data, f->tail + skip, length);
+        return (ssize_t) length;
+    }
+    if (offset + size > f->tail_start) {
+        size = (size_t) (f->tail_start - offset);
+    }
+    return read_some(f->fd, data, size, offset, f->stats);
+}
+
+static bool xfile_truncate(struct xfile *f)
+{
+    bool had_data = f->tail_start > 0;
+    f->tail_start = 0;
+    f->tail_used = 0;
+    return !had_data || ftruncate(f->fd, 0) == 0;
+}
+
+static void xfile_close(struct xfile *f)
+{
+    if (f->fd >= 0) {
+        close(f->fd);
+    }
+    free(f->tail);
+    f->fd = -1;
+    f->tail = NULL;
+}
+
+/* --- gap-encoded runs --- */
+
+static bool run_writer_open(struct run_writer *w, struct xfile *file, uint64_t offset, struct extmem_stats *stats)
+{
+    w->buffer = (unsigned char *) malloc(EXTMEM_IO_BUFFER);
+    w->file = file;
+    w->start = offset;
+    w->offset = offset;
+    w->used = 0;
+    w->last = 0;
+    w->count = 0;
+    w->stats = stats;
+    w->failed = w->buffer == NULL;
+    return !w->failed;
+}
+
+static void run_writer_flush(struct run_writer *w)
+{
+    if (!w->failed && w->used > 0) {
+        w->failed = !xfile_write(w->file, w->buffer, w->used, w->offset);
+        w->offset += w->used;
+        w->used = 0;
+    }
+}
+
+// values must be pushed in increasing order
+static void run_writer_put(struct run_writer *w, uint64_t value)
+{
+    if (w->used + 10 > EXTMEM_IO_BUFFER) {
+        run_writer_flush(w);
+    }
+    // a failed writer drops values, the caller sees it at close
+    if (w->failed) {
+        return;
+    }
+    uint64_t gap = value - w->last;
+    while (gap >= 0x80) {
+        w->buffer[w->used++] = (unsigned char) (gap | 0x80);
+        gap >>= 7;
+    }
+    w->buffer[w->used++] = (unsigned char) gap;
+    w->last = value;
+    w->count++;
+}
+
+// flushes and returns the run that was written, false on I/O failure
+static bool run_writer_close(struct run_writer *w, struct run *run)
+{
+    run_writer_flush(w);
+    free(w->buffer);
+    w->buffer = NULL;
+    run->offset = w->start;
+    run->bytes = w->offset - w->start;
+    run->count = w->count;
+    return !w->failed;
+}
+
+static bool run_reader_open(struct run_reader *r, struct xfile *file, struct run run, struct extmem_stats *stats)
+{
+    // BFS levels are often tiny, do not pay for a full buffer then
+    r->capacity = run.bytes < EXTMEM_IO_BUFFER ? (size_t) run.bytes + 1 : EXTMEM_IO_BUFFER;
+    r->buffer = (unsigned char *) malloc(r->capacity);
+    r->file = file;
+    r->offset = run.offset;
+    r->end = run.offset + run.bytes;
+    r->pos = 0;
+    r->length = 0;
+    r->last = 0;
+    r->remaining = run.count;
+    r->stats = stats;
+    r->failed = r->buffer == NULL;
+    return !r->failed;
+}
+
+static bool run_reader_next(struct run_reader *r, uint64_t *value)
+{
+    if (r->failed || r->remaining == 0) {
+        return false;
+    }
+    uint64_t gap = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (r->pos == r->length) {
+            size_t want = r->end - r->offset < r->capacity ? (size_t) (r->end - r->offset) : r->capacity;
+            ssize_t got = want > 0 ? xfile_read(r->file, r->buffer, want, r->offset) : 0;
+            if (got <= 0) {
+                r->failed = true;
+                return false;
+            }
+            r->offset += (uint64_t) got;
+            r->pos = 0;
+            r->length = (size_t) got;
+        }
+        unsigned char byte = r->buffer[r->pos++];
+        gap |= (uint64_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    r->last += gap;
+    r->remaining--;
+    *value = r->last;
+    return true;
+}
+
+static void run_reader_close(struct run_reader *r)
+{
+    free(r->buffer);
+    r->buffer = NULL;
+}
+
+/* --- external sort with deduplication --- */
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static size_t sort_unique(uint64_t *values, size_t count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    qsort(values, count, sizeof(uint64_t), compare_u64);
+    size_t unique = 1;
+    for (size_t i = 1; i < count; i++) {
+        if (values[i] != values[unique - 1]) {
+            values[unique++] = values[i];
+        }
+    }
+    return unique;
+}
+
+static bool sorter_init(struct sorter *s, struct xfile *file, size_t memory_cap, struct extmem_stats *stats)
+{
+    // half of the cap for the in-memory run, the other half for merge inputs
+    s->capacity = memory_cap / 2 / sizeof(uint64_t);
+    s->fanin = memory_cap / 2 / EXTMEM_IO_BUFFER;
+    if (s->fanin < 2) {
+        s->fanin = 2;
+    }
+    s->values = (uint64_t *) malloc(s->capacity * sizeof(uint64_t));
+    s->used = 0;
+    s->file = file;
+    s->end = 0;
+    s->runs = NULL;
+    s->num_runs = 0;
+    s->runs_capacity = 0;
+    s->stats = stats;
+    s->failed = s->values == NULL;
+    return !s->failed;
+}
+
+static void sorter_reset(struct sorter *s)
+{
+    s->used = 0;
+    s->num_runs = 0;
+    s->end = 0;
+    if (!xfile_truncate(s->file)) {
+        s->failed = true;
+    }
+}
+
+static void sorter_destroy(struct sorter *s)
+{
+    free(s->values);
+    free(s->runs);
+    s->values = NULL;
+    s->runs = NULL;
+}
+
+static bool sorter_add_run(struct sorter *s, struct run run)
+{
+    if (s->num_runs == s->runs_capacity) {
+        size_t new_capacity = s->runs_capacity == 0 ? 16 : s->runs_capacity * 2;
+        struct run *new_runs = (struct run *) realloc(s->runs, new_capacity * sizeof(struct run));
+        if (new_runs == NULL) {
+            return false;
+        }
+        s->runs = new_runs;
+        s->runs_capacity = new_capacity;
+    }
+    s->runs[s->num_runs++] = run;
+    return true;
+}
+
+// empties the buffer even on failure so sorter_push stays in bounds
+static void sorter_spill(struct sorter *s)
+{
+    size_t unique = sort_unique(s->values, s->used);
+    struct run_writer w;
+    struct run run;
+    s->used = 0;
+    if (s->failed || !run_writer_open(&w, s->file, s->end, s->stats)) {
+        s->failed = true;
+        return;
+    }
+    for (size_t i = 0; i < unique && !w.failed; i++) {
+        run_writer_put(&w, s->values[i]);
+    }
+    if (!run_writer_close(&w, &run) || !sorter_add_run(s, run)) {
+        s->failed = true;
+        return;
+    }
+    s->end += run.bytes;
+}
+
+static void sorter_push(struct sorter *s, uint64_t value)
+{
+    if (s->used == s->capacity) {
+        sorter_spill(s);
+    }
+    s->values[s->used++] = value;
+}
+
+static bool merger_open(struct merger *m, struct sorter *s, size_t first, size_t count);
+static bool merger_next(struct merger *m, uint64_t *value);
+static bool merger_failed(const struct merger *m);
+static void merger_close(struct merger *m);
+
+// sorts what is buffered and merges spilled runs until one merge pass is left
+static bool sorter_finish(struct sorter *s)
+{
+    if (s->failed) {
+        return false;
+    }
+    if (s->num_runs == 0) {
+        s->used = sort_unique(s->values, s->used);
+        return true;
+    }
+    if (s->used > 0) {
+        sorter_spill(s);
+    }
+    size_t first = 0;
+    while (!s->failed && s->num_runs - first > s->fanin) {
+        struct merger m;
+        struct run_writer w;
+        struct run run;
+        uint64_t value;
+        if (!merger_open(&m, s, first, s->fanin)) {
+            s->failed = true;
+            return false;
+        }
+        if (!run_writer_open(&w, s->file, s->end, s->stats)) {
+            merger_close(&m);
+            s->failed = true;
+            return false;
+        }
+        while (!w.failed && merger_next(&m, &value)) {
+            run_writer_put(&w, value);
+        }
+        bool read_failed = merger_failed(&m);
+        merger_close(&m);
+        if (!run_writer_close(&w, &run) || read_failed || !sorter_add_run(s, run)) {
+            s->failed = true;
+            return false;
+        }
+        s->end += run.bytes;
+        first += s->fanin;
+    }
+    // drop the runs that were merged away
+    memmove(s->runs, s->runs + first, (s->num_runs - first) * sizeof(struct run));
+    s->num_runs -= first;
+    return !s->failed;
+}
+
+static bool merger_open(struct merger *m, struct sorter *s, size_t first, size_t count)
+{
+    memset(m, 0, sizeof(*m));
+    if (s->num_runs == 0) {
+        m->memory = s->values;
+        m->memory_length = s->used;
+        return true;
+    }
+    m->readers = (struct run_reader *) calloc(count, sizeof(struct run_reader));
+    m->heads = (uint64_t *) malloc(count * sizeof(uint64_t));
+    m->live = (bool *) malloc(count * sizeof(bool));
+    if (m->readers == NULL || m->heads == NULL || m->live == NULL) {
+        merger_close(m);
+        return false;
+    }
+    m->count = count;
+    for (size_t i = 0; i < count; i++) {
+        if (!run_reader_open(&m->readers[i], s->file, s->runs[first + i], s->stats)) {
+            merger_close(m);
+            return false;
+        }
+        m->live[i] = run_reader_next(&m->readers[i], &m->heads[i]);
+    }
+    return true;
+}
+
+// yields the merged values in increasing order without duplicates
+static bool merger_next(struct merger *m, uint64_t *value)
+{
+    if (m->readers == NULL) {
+        if (m->memory_pos == m->memory_length) {
+            return false;
+        }
+        *value = m->memory[m->memory_pos++];
+        return true;
+    }
+    for (;;) {
+        size_t best = m->count;
+        for (size_t i = 0; i < m->count; i++) {
+            if (m->live[i] && (best == m->count || m->heads[i] < m->heads[best])) {
+                best = i;
+            }
+        }
+        if (best == m->count) {
+            return false;
+        }
+        uint64_t head = m->heads[best];
+        m->live[best] = run_reader_next(&m->readers[best], &m->heads[best]);
+        if (!m->has_last || head != m->last) {
+            m->has_last = true;
+            m->last = head;
+            *value = head;
+            return true;
+        }
+    }
+}
+
+// a reader that hit an I/O error ends its run early, the merge is incomplete
+static bool merger_failed(const struct merger *m)
+{
+    for (size_t i = 0; i < m->count; i++) {
+        if (m->readers[i].failed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void merger_close(struct merger *m)
+{
+    if (m->readers != NULL) {
+        for (size_t i = 0; i < m->count; i++) {
+            run_reader_close(&m->readers[i]);
+        }
+    }
+    free(m->readers);
+    free(m->heads);
+    free(m->live);
+    m->readers = NULL;
+    m->heads = NULL;
+    m->live = NULL;
+}
+
+/* --- walkability bitmap --- */
+
+static bool pager_init(struct pager *p, int fd, uint64_t width, size_t memory, struct extmem_stats *stats)
+{
+    p->fd = fd;
+    p->width = width;
+    p->row_bytes = (width + 7) / 8;
+    // each slot also needs its page number
+    p->num_slots = memory / (EXTMEM_PAGE_SIZE + sizeof(uint64_t));
+    if (p->num_slots == 0) {
+        p->num_slots = 1;
+    }
+    p->pages = (unsigned char *) malloc(p->num_slots * EXTMEM_PAGE_SIZE);
+    p->page_numbers = (uint64_t *) malloc(p->num_slots * sizeof(uint64_t));
+    p->stats = stats;
+    if (p->pages == NULL || p->page_numbers == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < p->num_slots; i++) {
+        p->page_numbers[i] = UINT64_MAX;
+    }
+    return true;
+}
+
+static void pager_destroy(struct pager *p)
+{
+    free(p->pages);
+    free(p->page_numbers);
+    p->pages = NULL;
+    p->page_numbers = NULL;
+}
+
+static bool pager_walkable(struct pager *p, uint64_t cell)
+{
+    uint64_t x = cell % p->width;
+    uint64_t y = cell / p->width;
+    uint64_t byte = EXTMEM_HEADER_SIZE + y * p->row_bytes + x / 8;
+    uint64_t page_number = byte / EXTMEM_PAGE_SIZE;
+    size_t slot = (size_t) (page_number % p->num_slots);
+    unsigned char *page = p->pages + slot * EXTMEM_PAGE_SIZE;
+    if (p->page_numbers[slot] != page_number) {
+        ssize_t got = read_some(p->fd, page, EXTMEM_PAGE_SIZE, page_number * EXTMEM_PAGE_SIZE, p->stats);
+        if (got <= 0 || (uint64_t) got <= byte % EXTMEM_PAGE_SIZE) {
+            p->page_numbers[slot] = UINT64_MAX;
+            return false;
+        }
+        p->page_numbers[slot] = page_number;
+    }
+    return (page[byte % EXTMEM_PAGE_SIZE] >> (x % 8)) & 1;
+}
+
+/* --- text input --- */
+
+// first pass: width from the rightmost wall and the two markers, like maze_create
+static bool text_scan(FILE *file, struct bin_header *header, struct extmem_stats *stats)
+{
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    uint64_t rightmost_wall = 0;
+    int markers = 0;
+
+    header->height = 0;
+    while ((length = getline(&line, &line_capacity, file)) > 0) {
+        stats->bytes_read += (uint64_t) length;
+        for (ssize_t x = 0; x < length; x++) {
+            // the bitmap only knows wall and open, anything else would turn walkable
+            if (line[x] >= '1' && line[x] <= '9') {
+                fprintf(stderr, "terrain costs need the solve mode\n");
+                free(line);
+                return false;
+            }
+            if (line[x] != '#' && line[x] != 'X' && line[x] != ' ' && line[x] != '\n') {
+                fprintf(stderr, "invalid character\n");
+                free(line);
+                return false;
+            }
+            if (line[x] == '#' && (uint64_t) x > rightmost_wall) {
+                rightmost_wall = (uint64_t) x;
+            }
+            if (line[x] == 'X') {
+                if (markers == 0) {
+                    header->entrance_x = (uint64_t) x;
+                    header->entrance_y = header->height;
+                } else if (markers == 1) {
+                    header->exit_x = (uint64_t) x;
+                    header->exit_y = header->height;
+                }
+                markers++;
+            }
+        }
+        header->height++;
+    }
+    free(line);
+    header->width = rightmost_wall + 1;
+    if (markers != 2) {
+        fprintf(stderr, "invalid amount of entrances\n");
+        return false;
+    }
+    // positions are ints like in struct maze, the checks count ids in 32 bits
+    if (header->width > INT_MAX || header->height > INT_MAX) {
+        fprintf(stderr, "maze too large\n");
+        return false;
+    }
+    return header->entrance_x < header->width && header->exit_x < header->width;
+}
+
+/*
+ * The is_valid rules checked while the text streams by. Isolated walls and
+ * the two doors need the row above and the row below, so every row is
+ * checked once the next one has been read, against a window of three rows.
+ * Wall connectivity is a union-find over the cells of only two rows: a
+ * component of the row above that reaches no cell of the current row can
+ * never grow again and is counted as finished.
+ */
+struct text_checks
+{
+    uint64_t width;
+    uint64_t height;
+    const struct bin_header *header;
+    char *rows[3];               // rows y - 2, y - 1 and y, cut or padded to width
+    unsigned char *column_walls; // walls per column, capped at 2
+    uint32_t *labels[2];         // component id per wall or marker cell of rows y - 1 and y, 0 elsewhere
+    uint32_t *parent;            // union-find over the ids of both rows
+    uint32_t *marks;
+    uint32_t num_ids;            // ids 1..num_ids belong to row y - 1
+    uint64_t components;         // components that ended above row y - 1
+    uint64_t isolated_row;       // first row with a wall without wall neighbours
+    uint64_t rule_row;           // first row with one wall and not one marker
+    bool entrance_door;
+    bool exit_door;
+};
+
+static bool checks_init(struct text_checks *c, const struct bin_header *header)
+{
+    memset(c, 0, sizeof(*c));
+    c->width = header->width;
+    c->header = header;
+    c->isolated_row = UINT64_MAX;
+    c->rule_row = UINT64_MAX;
+    size_t width = (size_t) header->width;
+    for (int i = 0; i < 3; i++) {
+        c->rows[i] = (char *) malloc(width);
+        if (c->rows[i] != NULL) {
+            memset(c->rows[i], ' ', width);
+        }
+    }
+    c->column_walls = (unsigned char *) calloc(width, 1);
+    c->labels[0] = (uint32_t *) calloc(width, sizeof(uint32_t));
+    c->labels[1] = (uint32_t *) calloc(width, sizeof(uint32_t));
+    // a row holds at most (width + 1) / 2 runs, two rows fit width + 1 ids
+    c->parent = (uint32_t *) malloc((width + 2) * sizeof(uint32_t));
+    c->marks = (uint32_t *) calloc(width + 2, sizeof(uint32_t));
+    return c->rows[0] != NULL && c->rows[1] != NULL && c->rows[2] != NULL && c->column_walls != NULL
+            && c->labels[0] != NULL && c->labels[1] != NULL && c->parent != NULL && c->marks != NULL;
+}
+
+static void checks_destroy(struct text_checks *c)
+{
+    for (int i = 0; i < 3; i++) {
+        free(c->rows[i]);
+    }
+    free(c->column_walls);
+    free(c->labels[0]);
+    free(c->labels[1]);
+    free(c->parent);
+    free(c->marks);
+}
+
+static uint32_t checks_find(uint32_t *parent, uint32_t id)
+{
+    while (parent[id] != id) {
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+    }
+    return id;
+}
+
+// labels row y against row y - 1 and counts the components of row y - 1 that stop there
+static void checks_label_row(struct text_checks *c)
+{
+    const char *row = c->rows[2];
+    const uint32_t *above = c->labels[0];
+    uint32_t *labels = c->labels[1];
+    uint32_t *parent = c->parent;
+    uint32_t next_id = c->num_ids;
+
+    for (uint64_t x = 0; x < c->width; x++) {
+        if (row[x] != '#' && row[x] != 'X') {
+            labels[x] = 0;
+            continue;
+        }
+        if (x > 0 && labels[x - 1] != 0) {
+            labels[x] = labels[x - 1];
+        } else {
+            labels[x] = ++next_id;
+            parent[next_id] = next_id;
+        }
+        if (above[x] != 0) {
+            uint32_t a = checks_find(parent, labels[x]);
+            uint32_t b = checks_find(parent, above[x]);
+            parent[a > b ? a : b] = a > b ? b : a;
+        }
+    }
+
+    for (uint64_t x = 0; x < c->width; x++) {
+        if (labels[x] != 0) {
+            c->marks[checks_find(parent, labels[x])] = 1;
+        }
+    }
+    for (uint32_t id = 1; id <= c->num_ids; id++) {
+        uint32_t root = checks_find(parent, id);
+        if (c->marks[root] == 0) {
+            c->components++;
+            c->marks[root] = 1;
+        }
+    }
+    memset(c->marks, 0, ((size_t) next_id + 1) * sizeof(uint32_t));
+
+    // renumber the roots of row y to 1..num_ids for the next row
+    c->num_ids = 0;
+    for (uint64_t x = 0; x < c->width; x++) {
+        if (labels[x] != 0) {
+            uint32_t root = checks_find(parent, labels[x]);
+            if (c->marks[root] == 0) {
+                c->marks[root] = ++c->num_ids;
+            }
+            labels[x] = c->marks[root];
+        }
+    }
+    memset(c->marks, 0, ((size_t) next_id + 1) * sizeof(uint32_t));
+    for (uint32_t id = 1; id <= c->num_ids; id++) {
+        parent[id] = id;
+    }
+    c->labels[1] = c->labels[0];
+    c->labels[0] = labels;
+}
+
+static bool checks_is_door(const struct text_checks *c, uint64_t x)
+{
+    const char *row = c->rows[1];
+    bool left = x > 0 && row[x - 1] == '#';
+    bool right = x + 1 < c->width && row[x + 1] == '#';
+    bool up = c->rows[0][x] == '#';
+    bool down = c->rows[2][x] == '#';
+    return (left && right && !up && !down) || (up && down && !left && !right);
+}
+
+// walls and doors of row y - 1, whose neighbours are all in the window now
+static void checks_middle_row(struct text_checks *c, uint64_t y)
+{
+    const char *row = c->rows[1];
+    for (uint64_t x = 0; x < c->width && c->isolated_row == UINT64_MAX; x++) {
+        if (row[x] == '#' && (x == 0 || row[x - 1] != '#') && (x + 1 == c->width || row[x + 1] != '#')
+                && c->rows[0][x] != '#' && c->rows[2][x] != '#') {
+            c->isolated_row = y;
+        }
+    }
+    if (c->header->entrance_y == y) {
+        c->entrance_door = checks_is_door(c, c->header->entrance_x);
+    }
+    if (c->header->exit_y == y) {
+        c->exit_door = checks_is_door(c, c->header->exit_x);
+    }
+}
+
+static void checks_row(struct text_checks *c, const char *line, uint64_t length)
+{
+    char *row = c->rows[2];
+    uint64_t limit = length < c->width ? length : c->width;
+    size_t walls = 0;
+    size_t markers = 0;
+    for (uint64_t x = 0; x < limit; x++) {
+        row[x] = line[x] == '#' || line[x] == 'X' ? line[x] : ' ';
+        if (row[x] == '#') {
+            walls++;
+            if (c->column_walls[x] < 2) {
+                c->column_walls[x]++;
+            }
+        } else if (row[x] == 'X') {
+            markers++;
+        }
+    }
+    memset(row + limit, ' ', (size_t) (c->width - limit));
+    if (walls == 1 && markers != 1 && c->rule_row == UINT64_MAX) {
+        c->rule_row = c->height;
+    }
+    checks_label_row(c);
+    if (c->height > 0) {
+        checks_middle_row(c, c->height - 1);
+    }
+    c->rows[2] = c->rows[0];
+    c->rows[0] = c->rows[1];
+    c->rows[1] = row;
+    c->height++;
+}
+
+// the checks of is_valid in the same order, with the same messages
+static bool checks_finish(struct text_checks *c)
+{
+    // below the last row there are no walls
+    memset(c->rows[2], ' ', (size_t) c->width);
+    if (c->height > 0) {
+        checks_middle_row(c, c->height - 1);
+    }
+    uint64_t components = c->components + c->num_ids;
+
+    if (c->isolated_row != UINT64_MAX && (c->rule_row == UINT64_MAX || c->isolated_row <= c->rule_row)) {
+        return false;
+    }
+    if (c->rule_row != UINT64_MAX) {
+        fprintf(stderr, "only one line#\n");
+        return false;
+    }
+    if (!c->entrance_door) {
+        fprintf(stderr, "invalid entrance\n");
+        return false;
+    }
+    if (!c->exit_door) {
+        fprintf(stderr, "invalid exit\n");
+        return false;
+    }
+    if (components != 1) {
+        fprintf(stderr, "not connected\n");
+        return false;
+    }
+    for (uint64_t x = 0; x < c->width; x++) {
+        int column_markers = (c->header->entrance_x == x) + (c->header->exit_x == x);
+        if (c->column_walls[x] == 1 && column_markers != 1) {
+            fprintf(stderr, "alone col\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+// second pass: one bitmap row per text row and the streamed checks, also finds the leftmost printed column
+static enum extmem_status text_to_bitmap(FILE *file, int fd, const struct bin_header *header, uint64_t *leftmost, struct extmem_stats *stats)
+{
+    struct text_checks checks;
+    if (!checks_init(&checks, header)) {
+        checks_destroy(&checks);
+        return EXTMEM_IO_FAILED;
+    }
+
+    unsigned char head[EXTMEM_HEADER_SIZE];
+    uint64_t fields[6] = { header->width, header->height, header->entrance_x, header->entrance_y, header->exit_x, header->exit_y };
+    memcpy(head, EXTMEM_MAGIC, 8);
+    memcpy(head + 8, fields, sizeof(fields));
+    uint64_t row_bytes = (header->width + 7) / 8;
+    unsigned char *row = (unsigned char *) malloc(row_bytes);
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    bool ok = row != NULL && write_all(fd, head, sizeof(head), 0, stats);
+    *leftmost = header->width;
+
+    for (uint64_t y = 0; ok && (length = getline(&line, &line_capacity, file)) > 0; y++) {
+        stats->bytes_read += (uint64_t) length;
+        uint64_t limit = maze_row_end(line, (size_t) length, header->width);
+        memset(row, 0, row_bytes);
+        for (uint64_t x = 0; x < limit; x++) {
+            char c = x < (uint64_t) length ? line[x] : ' ';
+            if (c != '#') {
+                row[x / 8] |= (unsigned char) (1u << (x % 8));
+            }
+        }
+        for (uint64_t x = 0; x < header->width && x < *leftmost; x++) {
+            if (x < (uint64_t) length && line[x] != ' ') {
+                *leftmost = x;
+                break;
+            }
+        }
+        checks_row(&checks, line, (uint64_t) length);
+        ok = write_all(fd, row, row_bytes, EXTMEM_HEADER_SIZE + y * row_bytes, stats);
+    }
+    free(line);
+    free(row);
+    bool valid = ok && checks_finish(&checks);
+    checks_destroy(&checks);
+    if (!ok) {
+        return EXTMEM_IO_FAILED;
+    }
+    return valid ? EXTMEM_OK : EXTMEM_INVALID;
+}
+
+static bool read_header(int fd, struct bin_header *header, struct extmem_stats *stats)
+{
+    unsigned char head[EXTMEM_HEADER_SIZE];
+    uint64_t fields[6];
+    if (read_some(fd, head, sizeof(head), 0, stats) != (ssize_t) sizeof(head) || memcmp(head, EXTMEM_MAGIC, 8) != 0) {
+        return false;
+    }
+    memcpy(fields, head + 8, sizeof(fields));
+    header->width = fields[0];
+    header->height = fields[1];
+    header->entrance_x = fields[2];
+    header->entrance_y = fields[3];
+    header->exit_x = fields[4];
+    header->exit_y = fields[5];
+    return header->width > 0 && header->entrance_x < header->width && header->exit_x < header->width
+            && header->entrance_y < header->height && header->exit_y < header->height;
+}
+
+/*
+ * Converts a text maze to the binary bitmap format read by extmem_solve.
+ * The text must pass the same checks as maze_create, minus terrain digits.
+ */
+bool extmem_convert(const char *input_path, const char *output_path, struct extmem_stats *stats)
+{
+    assert(input_path != NULL);
+    assert(output_path != NULL);
+    assert(stats != NULL);
+    memset(stats, 0, sizeof(*stats));
+
+    FILE *input_file = fopen(input_path, "r");
+    if (input_file == NULL) {
+        return false;
+    }
+    int fd = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    struct bin_header header;
+    uint64_t leftmost;
+    bool ok = fd >= 0 && text_scan(input_file, &header, stats);
+    if (ok) {
+        rewind(input_file);
+        ok = text_to_bitmap(input_file, fd, &header, &leftmost, stats) == EXTMEM_OK;
+    }
+    fclose(input_file);
+    if (fd >= 0) {
+        close(fd);
+    }
+    return ok;
+}
+
+/* --- solver --- */
+
+static bool write_level_index(struct xfile *index, uint64_t level, struct run run)
+{
+    uint64_t record[3] = { run.offset, run.bytes, run.count };
+    return xfile_write(index, record, sizeof(record), level * sizeof(record));
+}
+
+static bool read_level_index(struct xfile *index, uint64_t level, struct run *run)
+{
+    uint64_t record[3];
+    if (xfile_read(index, record, sizeof(record), level * sizeof(record)) != (ssize_t) sizeof(record)) {
+        return false;
+    }
+    run->offset = record[0];
+    run->bytes = record[1];
+    run->count = record[2];
+    return true;
+}
+
+static void push_neighbours(struct sorter *s, uint64_t cell, const struct bin_header *header)
+{
+    uint64_t x = cell % header->width;
+    uint64_t y = cell / header->width;
+    if (y > 0) {
+        sorter_push(s, cell - header->width);
+    }
+    if (x + 1 < header->width) {
+        sorter_push(s, cell + 1);
+    }
+    if (y + 1 < header->height) {
+        sorter_push(s, cell + header->width);
+    }
+    if (x > 0) {
+        sorter_push(s, cell - 1);
+    }
+}
+
+static bool is_adjacent(uint64_t a, uint64_t b, uint64_t width)
+{
+    uint64_t low = a < b ? a : b;
+    uint64_t high = a < b ? b : a;
+    return high - low == width || (high - low == 1 && high % width != 0);
+}
+
+// advances a sorted level reader to the first value >= target, reports a hit
+static bool level_contains(struct run_reader *r, bool *live, uint64_t *head, uint64_t target)
+{
+    while (*live && *head < target) {
+        *live = run_reader_next(r, head);
+    }
+    return *live && *head == target;
+}
+
+/*
+ * One BFS step: sorted, unique neighbours of 'current' minus 'previous' and
+ * 'current', filtered by the bitmap, written as the next level.
+ */
+static bool expand_level(struct sorter *s, struct pager *pager, struct xfile *levels, uint64_t levels_end,
+        struct run previous, struct run current, const struct bin_header *header, struct run *next, uint64_t target, bool *found)
+{
+    struct run_reader reader;
+    uint64_t cell;
+    sorter_reset(s);
+    if (!run_reader_open(&reader, levels, current, s->stats)) {
+        return false;
+    }
+    while (!s->failed && run_reader_next(&reader, &cell)) {
+        push_neighbours(s, cell, header);
+    }
+    bool ok = !reader.failed;
+    run_reader_close(&reader);
+    if (!ok || !sorter_finish(s)) {
+        return false;
+    }
+
+    struct merger m;
+    struct run_reader previous_reader = { 0 };
+    struct run_reader current_reader = { 0 };
+    struct run_writer w;
+    uint64_t previous_head = 0;
+    uint64_t current_head = 0;
+    if (!merger_open(&m, s, 0, s->num_runs)) {
+        return false;
+    }
+    ok = run_reader_open(&previous_reader, levels, previous, s->stats)
+            && run_reader_open(&current_reader, levels, current, s->stats)
+            && run_writer_open(&w, levels, levels_end, s->stats);
+    if (ok) {
+        bool previous_live = run_reader_next(&previous_reader, &previous_head);
+        bool current_live = run_reader_next(&current_reader, &current_head);
+        while (!w.failed && merger_next(&m, &cell)) {
+            if (level_contains(&previous_reader, &previous_live, &previous_head, cell)
+                    || level_contains(&current_reader, &current_live, &current_head, cell)
+                    || !pager_walkable(pager, cell)) {
+                continue;
+            }
+            run_writer_put(&w, cell);
+            if (cell == target) {
+                *found = true;
+            }
+        }
+        ok = run_writer_close(&w, next) && !previous_reader.failed && !current_reader.failed && !merger_failed(&m);
+    }
+    run_reader_close(&previous_reader);
+    run_reader_close(&current_reader);
+    merger_close(&m);
+    return ok;
+}
+
+// walks the stored levels backwards from the exit, feeding path cells to the sorter
+static bool trace_back(struct sorter *s, struct xfile *levels, struct xfile *index, const struct bin_header *header, uint64_t target, uint64_t length)
+{
+    uint64_t cell = target;
+    sorter_reset(s);
+    sorter_push(s, cell);
+    for (uint64_t level = length; level-- > 0;) {
+        struct run run;
+        struct run_reader reader;
+        uint64_t value;
+        bool found = false;
+        if (!read_level_index(index, level, &run) || !run_reader_open(&reader, levels, run, s->stats)) {
+            return false;
+        }
+        while (!found && run_reader_next(&reader, &value) && value <= cell + header->width) {
+            found = is_adjacent(value, cell, header->width);
+        }
+        run_reader_close(&reader);
+        if (!found) {
+            return false;
+        }
+        cell = value;
+        sorter_push(s, cell);
+    }
+    return sorter_finish(s);
+}
+
+// second text pass, prints like maze_print with path cells replaced by 'o'
+static bool write_overlay(const char *input_path, const char *output_path, const struct bin_header *header,
+        uint64_t leftmost, struct sorter *path, struct extmem_stats *stats)
+{
+    FILE *input_file = fopen(input_path, "r");
+    if (input_file == NULL) {
+        return false;
+    }
+    FILE *output_file = fopen(output_path, "w");
+    if (output_file == NULL) {
+        fclose(input_file);
+        return false;
+    }
+
+    struct merger m;
+    if (!merger_open(&m, path, 0, path->num_runs)) {
+        fclose(input_file);
+        fclose(output_file);
+        return false;
+    }
+    uint64_t next_path = 0;
+    bool path_live = merger_next(&m, &next_path);
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+
+    for (uint64_t y = 0; (length = getline(&line, &line_capacity, input_file)) > 0; y++) {
+        stats->bytes_read += (uint64_t) length;
+        uint64_t limit = maze_row_end(line, (size_t) length, header->width);
+        for (uint64_t x = leftmost; x < limit; x++) {
+            uint64_t cell = y * header->width + x;
+            while (path_live && next_path < cell) {
+                path_live = merger_next(&m, &next_path);
+            }
+            bool on_path = path_live && next_path == cell;
+            char c = x < (uint64_t) length ? line[x] : ' ';
+            // the newline cell of a short row is walkable, maze_print shows it once marked
+            if (c == '\n' && !on_path) {
+                continue;
+            }
+            fputc(on_path ? 'o' : c, output_file);
+            stats->bytes_written++;
+        }
+        fputc('\n', output_file);
+        stats->bytes_written++;
+    }
+
+    free(line);
+    merger_close(&m);
+    fclose(input_file);
+    return fclose(output_file) == 0;
+}
+
+/*
+ * Solves the maze at input_path (text or binary) with bounded memory.
+ * When output_path is set the input must be text, and the solved maze is
+ * written there in the same format as maze_print; a binary input is refused
+ * before any search.
+ */
+enum extmem_status extmem_solve(const char *input_path, const char *output_path, const struct extmem_options *options, struct extmem_stats *stats)
+{
+    assert(input_path != NULL);
+    assert(options != NULL);
+    assert(stats != NULL);
+    memset(stats, 0, sizeof(*stats));
+
+    struct bin_header header;
+    uint64_t leftmost = 0;
+    int bitmap_fd = open(input_path, O_RDONLY);
+    if (bitmap_fd < 0) {
+        return EXTMEM_CANNOT_READ;
+    }
+    bool text_input = !read_header(bitmap_fd, &header, stats);
+    if (text_input) {
+        // text input, convert to a scratch bitmap first
+        close(bitmap_fd);
+        FILE *input_file = fopen(input_path, "r");
+        if (input_file == NULL) {
+            return EXTMEM_CANNOT_READ;
+        }
+        if (!text_scan(input_file, &header, stats)) {
+            fclose(input_file);
+            return EXTMEM_INVALID;
+        }
+        rewind(input_file);
+        bitmap_fd = temp_open(options->temp_dir);
+        enum extmem_status status = EXTMEM_IO_FAILED;
+        if (bitmap_fd >= 0) {
+            status = text_to_bitmap(input_file, bitmap_fd, &header, &leftmost, stats);
+        }
+        fclose(input_file);
+        if (status != EXTMEM_OK) {
+            if (bitmap_fd >= 0) {
+                close(bitmap_fd);
+            }
+            return status;
+        }
+    } else if (output_path != NULL) {
+        close(bitmap_fd);
+        return EXTMEM_NEEDS_TEXT;
+    }
+
+    /*
+     * The fixed buffers come off the cap first. Of the rest the sorter gets
+     * half, bitmap pages a quarter and the level tail an eighth; the last
+     * eighth covers run lists, merge heads and the text row buffer.
+     */
+    assert(options->memory_cap >= EXTMEM_MIN_MEMORY);
+    size_t memory = options->memory_cap - EXTMEM_FIXED_MEMORY;
+    struct pager pager;
+    struct xfile levels;
+    struct xfile index;
+    struct xfile scratch;
+    struct sorter s = { 0 };
+    bool ok = pager_init(&pager, bitmap_fd, header.width, memory / 4, stats);
+    ok = xfile_open(&levels, options->temp_dir, memory / 8, stats) && ok;
+    ok = xfile_open(&index, options->temp_dir, EXTMEM_IO_BUFFER, stats) && ok;
+    ok = xfile_open(&scratch, options->temp_dir, 0, stats) && ok;
+    ok = ok && sorter_init(&s, &scratch, memory / 2, stats);
+
+    uint64_t start = header.entrance_y * header.width + header.entrance_x;
+    uint64_t target = header.exit_y * header.width + header.exit_x;
+    struct run previous = { 0, 0, 0 };
+    struct run current = { 0, 0, 0 };
+    struct run_writer w;
+    bool found = start == target;
+
+    if (ok) {
+        ok = run_writer_open(&w, &levels, 0, stats);
+        if (ok) {
+            run_writer_put(&w, start);
+            ok = run_writer_close(&w, &current) && write_level_index(&index, 0, current);
+        }
+    }
+    uint64_t levels_end = current.bytes;
+    uint64_t level = 0;
+    while (ok && !found && current.count > 0) {
+        struct run next;
+        ok = expand_level(&s, &pager, &levels, levels_end, previous, current, &header, &next, target, &found)
+                && write_level_index(&index, level + 1, next);
+        levels_end += next.bytes;
+        previous = current;
+        current = next;
+        level++;
+    }
+    stats->levels = level + 1;
+
+    if (ok && found) {
+        stats->path_length = level;
+        if (output_path != NULL) {
+            ok = trace_back(&s, &levels, &index, &header, target, level)
+                    && write_overlay(input_path, output_path, &header, leftmost, &s, stats);
+        }
+    }
+
+    sorter_destroy(&s);
+    pager_destroy(&pager);
+    close(bitmap_fd);
+    xfile_close(&levels);
+    xfile_close(&index);
+    xfile_close(&scratch);
+    if (!ok) {
+        return EXTMEM_IO_FAILED;
+    }
+    return found ? EXTMEM_OK : EXTMEM_NO_SOLUTION;
+}
+
+const char *extmem_status_message(enum extmem_status status)
+{
+    return status_messages[status];
+}
@@ -0,0 +1,40 @@
+#ifndef EXTMEM_H
+#define EXTMEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// smallest accepted memory cap, the fixed buffers plus a sort buffer and two merge inputs
+#define EXTMEM_MIN_MEMORY ((size_t) 1 << 20)
+#define EXTMEM_DEFAULT_MEMORY ((size_t) 64 << 20)
+
+enum extmem_status
+{
+    EXTMEM_OK,
+    EXTMEM_CANNOT_READ,
+    EXTMEM_INVALID,
+    EXTMEM_NEEDS_TEXT,   // path overlay requested for a binary input
+    EXTMEM_NO_SOLUTION,
+    EXTMEM_IO_FAILED,    // scratch or output file I/O, or a buffer allocation
+};
+
+struct extmem_options
+{
+    size_t memory_cap;    // bytes for sort buffers, merge inputs and page cache
+    const char *temp_dir; // directory for unlinked scratch files
+};
+
+struct extmem_stats
+{
+    uint64_t path_length; // steps from entrance to exit
+    uint64_t levels;      // BFS levels written to disk
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+};
+
+bool extmem_convert(const char *input_path, const char *output_path, struct extmem_stats *stats);
+enum extmem_status extmem_solve(const char *input_path, const char *output_path, const struct extmem_options *options, struct extmem_stats *stats);
+const char *extmem_status_message(enum extmem_status status);
+
+#endif // EXTMEM_H
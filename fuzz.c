@@ -0,0 +1,900 @@
+#include "fuzz.h"
+
+#include "ccl.h"
+#include "compact.h"
+#include "dial.h"
+#include "extmem.h"
+#include "gen.h"
+#include "kernel.h"
+#include "maze.h"
+#include "multi.h"
+#include "path.h"
+#include "tiled.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Differential testing harness.
+ * Every input is fed to all loaders, validators and solvers, and their
+ * answers are compared with the reference path: maze_create with the
+ * original is_connected BFS and the original solve_maze search. Any
+ * disagreement is reported.
+ *
+ * fuzz_check_input is the single-input entry point (AFL runs it through
+ * './maze fuzz-one FILE', libFuzzer through LLVMFuzzerTestOneInput below),
+ * fuzz_run feeds it generated and mutated mazes, and fuzz_perf times every
+ * engine on growing inputs to catch superlinear behaviour.
+ */
+
+#define FUZZ_NO_PATH ((size_t) -1)
+#define FUZZ_EXT_MEMORY EXTMEM_MIN_MEMORY
+#define FUZZ_PERF_REPEATS 3
+#define FUZZ_PERF_GROWTH 4
+#define FUZZ_PERF_LIMIT 2.0 // allowed growth of time per cell between sizes
+#define FUZZ_ORACLE_CELLS 4096 // largest grid the quadratic Dijkstra oracle runs on
+
+static bool load_from_memory(struct maze *maze, const char *data, size_t size, const struct maze_options *options)
+{
+    // fmemopen rejects empty buffers, an empty maze reads like one blank line less
+    static const char empty[] = "\n";
+    FILE *file = size > 0 ? fmemopen((void *) data, size, "r") : fmemopen((void *) empty, 1, "r");
+    if (file == NULL) {
+        return false;
+    }
+    bool ok = maze_create_with_options(maze, file, options);
+    fclose(file);
+    if (!ok) {
+        maze_destroy(maze);
+    }
+    return ok;
+}
+
+// loader chatter on stderr is expected for invalid inputs, keep it out of reports
+static int silence_stderr(void)
+{
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO);
+    FILE *null_file = fopen("/dev/null", "w");
+    if (null_file != NULL) {
+        dup2(fileno(null_file), STDERR_FILENO);
+        fclose(null_file);
+    }
+    return saved;
+}
+
+static void restore_stderr(int saved)
+{
+    fflush(stderr);
+    if (saved >= 0) {
+        dup2(saved, STDERR_FILENO);
+        close(saved);
+    }
+}
+
+static size_t count_path_tiles(struct maze *maze)
+{
+    size_t count = 0;
+    for (size_t y = 0; y < maze->height; y++) {
+        for (size_t x = 0; x < maze->width; x++) {
+            count += maze->tiles[y][x].value == 'o';
+        }
+    }
+    return count;
+}
+
+static size_t reference_path_length(const char *data, size_t size)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = true };
+    if (!load_from_memory(&maze, data, size, &options)) {
+        return FUZZ_NO_PATH;
+    }
+    size_t length = solve_maze(&maze) ? count_path_tiles(&maze) - 1 : FUZZ_NO_PATH;
+    maze_destroy(&maze);
+    return length;
+}
+
+/*
+ * Cheapest entrance-to-exit cost by a brute-force Dijkstra that scans every
+ * cell for the next one to settle. Quadratic, but it shares nothing with
+ * Dial's buckets, so it is an independent oracle for small mazes.
+ */
+static size_t reference_weighted_cost(const struct maze *maze)
+{
+    size_t cells = maze->width * maze->height;
+    size_t *dist = (size_t *) malloc(cells * sizeof(size_t));
+    bool *settled = (bool *) calloc(cells, sizeof(bool));
+    size_t cost = FUZZ_NO_PATH;
+    if (dist != NULL && settled != NULL) {
+        for (size_t i = 0; i < cells; i++) {
+            dist[i] = FUZZ_NO_PATH;
+        }
+        dist[(size_t) maze->entrance.y * maze->width + maze->entrance.x] = 0;
+        for (;;) {
+            size_t best = cells;
+            for (size_t i = 0; i < cells; i++) {
+                if (!settled[i] && dist[i] != FUZZ_NO_PATH && (best == cells || dist[i] < dist[best])) {
+                    best = i;
+                }
+            }
+            if (best == cells) {
+                break;
+            }
+            settled[best] = true;
+            for (int d = 0; d < 4; d++) {
+                struct position adj = { (int) (best % maze->width) + maze_dx[d], (int) (best / maze->width) + maze_dy[d] };
+                if (!maze_is_walkable(maze, adj)) {
+                    continue;
+                }
+                size_t adj_cell = (size_t) adj.y * maze->width + adj.x;
+                size_t next_dist = dist[best] + maze->tiles[adj.y][adj.x].cost;
+                if (next_dist < dist[adj_cell]) {
+                    dist[adj_cell] = next_dist;
+                }
+            }
+        }
+        cost = dist[(size_t) maze->exit.y * maze->width + maze->exit.x];
+    }
+    free(dist);
+    free(settled);
+    return cost;
+}
+
+// summed cost of the tiles marked 'o', the entrance itself is free
+static size_t marked_path_cost(const struct maze *maze)
+{
+    size_t cost = 0;
+    for (size_t y = 0; y < maze->height; y++) {
+        for (size_t x = 0; x < maze->width; x++) {
+            cost += maze->tiles[y][x].value == 'o' ? maze->tiles[y][x].cost : 0;
+        }
+    }
+    return cost - maze->tiles[maze->entrance.y][maze->entrance.x].cost;
+}
+
+static enum extmem_status extmem_run(const char *data, size_t size, size_t *length, size_t *marked)
+{
+    // the external solver works on files, round-trip through scratch files
+    char input_path[] = "/tmp/maze-fuzz-XXXXXX";
+    char output_path[] = "/tmp/maze-fuzz-XXXXXX";
+    int input_fd = mkstemp(input_path);
+    int output_fd = mkstemp(output_path);
+    enum extmem_status status = EXTMEM_IO_FAILED;
+    *length = FUZZ_NO_PATH;
+    *marked = 0;
+    if (input_fd >= 0 && output_fd >= 0 && write(input_fd, data, size) == (ssize_t) size) {
+        struct extmem_options options = { .memory_cap = FUZZ_EXT_MEMORY, .temp_dir = "/tmp" };
+        struct extmem_stats stats;
+        status = extmem_solve(input_path, output_path, &options, &stats);
+        if (status == EXTMEM_OK) {
+            *length = stats.path_length;
+            FILE *output_file = fopen(output_path, "r");
+            for (int c; output_file != NULL && (c = fgetc(output_file)) != EOF;) {
+                *marked += c == 'o';
+            }
+            if (output_file != NULL) {
+                fclose(output_file);
+            }
+        }
+    }
+    if (input_fd >= 0) {
+        close(input_fd);
+        unlink(input_path);
+    }
+    if (output_fd >= 0) {
+        close(output_fd);
+        unlink(output_path);
+    }
+    return status;
+}
+
+static bool report_mismatch(FILE *report, const char *what, size_t expected, size_t actual)
+{
+    if (expected == actual) {
+        return true;
+    }
+    if (report != NULL) {
+        fprintf(report, "mismatch: %s, expected %zd, got %zd\n", what, (ssize_t) expected, (ssize_t) actual);
+    }
+    return false;
+}
+
+// the compact solver reads the text itself; digits are rejected there and NUL bytes end lines differently
+static bool compact_applies(const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] == '\0' || (data[i] >= '1' && data[i] <= '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool extmem_applies(const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != '#' && data[i] != 'X' && data[i] != ' ' && data[i] != '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static enum compact_status compact_run(const char *data, size_t size, struct maze_path *path, size_t *marked)
+{
+    static const char empty[] = "\n";
+    FILE *input_file = size > 0 ? fmemopen((void *) data, size, "r") : fmemopen((void *) empty, 1, "r");
+    char *printed = NULL;
+    size_t printed_size = 0;
+    FILE *output_file = open_memstream(&printed, &printed_size);
+    enum compact_status status = COMPACT_NO_MEMORY;
+    if (input_file != NULL && output_file != NULL) {
+        struct compact_stats stats;
+        status = compact_solve(input_file, output_file, path, &stats);
+    }
+    if (input_file != NULL) {
+        fclose(input_file);
+    }
+    if (output_file != NULL) {
+        fclose(output_file);
+    }
+    *marked = 0;
+    for (size_t i = 0; i < printed_size; i++) {
+        *marked += printed[i] == 'o';
+    }
+    free(printed);
+    return status;
+}
+
+// the route may differ from the reference on ties, so check that it is walkable instead
+static bool compare_compact(const char *data, size_t size, size_t expected, FILE *report)
+{
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = true };
+    struct maze maze;
+    if (!load_from_memory(&maze, data, size, &options)) {
+        return report_mismatch(report, "reload reference", true, false);
+    }
+    struct maze_path path;
+    size_t marked;
+    enum compact_status status = compact_run(data, size, &path, &marked);
+    bool agree = report_mismatch(report, "compact_solve", expected, status == COMPACT_OK ? path.length : FUZZ_NO_PATH);
+    if (status == COMPACT_OK) {
+        agree &= report_mismatch(report, "compact_solve path", expected + 1, marked);
+        bool walkable = path.start.x == maze.entrance.x && path.start.y == maze.entrance.y;
+        for (size_t i = 0; walkable && i <= path.length; i++) {
+            struct position pos = maze_path_position(&path, i);
+            walkable = maze_is_walkable(&maze, pos);
+            if (i == path.length) {
+                walkable &= pos.x == maze.exit.x && pos.y == maze.exit.y;
+            }
+        }
+        agree &= report_mismatch(report, "compact_solve route", true, walkable);
+        maze_path_destroy(&path);
+    }
+    maze_destroy(&maze);
+    return agree;
+}
+
+// the kernels walk neighbours in the reference order, so the marked grids must be identical
+static bool compare_kernel_solve(const char *data, size_t size, size_t expected, FILE *report)
+{
+    struct maze_options reference_options = { .allow_many_markers = false, .threads = 1, .reference_checks = true };
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    struct maze reference;
+    struct maze maze;
+    if (!load_from_memory(&reference, data, size, &reference_options)) {
+        return report_mismatch(report, "reload reference", true, false);
+    }
+    if (!load_from_memory(&maze, data, size, &options)) {
+        maze_destroy(&reference);
+        return report_mismatch(report, "reload", true, false);
+    }
+
+    bool agree = true;
+    size_t index_bytes[3] = { 2, 4, 8 };
+    for (int i = 0; i < 3; i++) {
+        if (index_bytes[i] < kernel_index_bytes(&maze)) {
+            continue;
+        }
+        size_t length;
+        if (!kernel_solve_length(&maze, index_bytes[i], &length)) {
+            length = FUZZ_NO_PATH;
+        }
+        agree &= report_mismatch(report, "kernel_solve_length", expected, length);
+    }
+
+    // path query: same route without writing to the maze, drawn only on a copy
+    size_t marks = count_path_tiles(&maze);
+    struct maze_path path;
+    bool found = maze_solve_path(&maze, &path);
+    agree &= report_mismatch(report, "maze_solve_path", expected, found ? path.length : FUZZ_NO_PATH);
+    char *printed = NULL;
+    size_t printed_size = 0;
+    if (found) {
+        struct position end = maze_path_position(&path, path.length);
+        agree &= report_mismatch(report, "maze_path_position end", true, end.x == maze.exit.x && end.y == maze.exit.y);
+        FILE *stream = open_memstream(&printed, &printed_size);
+        if (stream != NULL) {
+            maze_path_print(&maze, &path, stream);
+            fclose(stream);
+        }
+        maze_path_destroy(&path);
+    }
+    agree &= report_mismatch(report, "maze_solve_path untouched", marks, count_path_tiles(&maze));
+
+    agree &= report_mismatch(report, "solve_maze kernel", solve_maze(&reference), solve_maze(&maze));
+    for (size_t y = 0; agree && y < maze.height; y++) {
+        for (size_t x = 0; agree && x < maze.width; x++) {
+            agree &= report_mismatch(report, "solve_maze kernel tile", reference.tiles[y][x].value, maze.tiles[y][x].value);
+        }
+    }
+    if (printed != NULL) {
+        char *expected_print = NULL;
+        size_t expected_size = 0;
+        FILE *stream = open_memstream(&expected_print, &expected_size);
+        if (stream != NULL) {
+            maze_print(&reference, stream);
+            fclose(stream);
+            agree &= report_mismatch(report, "maze_path_print", true,
+                    expected_size == printed_size && memcmp(expected_print, printed, printed_size) == 0);
+        }
+        free(expected_print);
+        free(printed);
+    }
+    maze_destroy(&reference);
+    maze_destroy(&maze);
+    return agree;
+}
+
+static bool compare_valid_maze(const char *data, size_t size, FILE *report)
+{
+    bool agree = true;
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    size_t expected = reference_path_length(data, size);
+
+    agree &= compare_kernel_solve(data, size, expected, report);
+    if (compact_applies(data, size)) {
+        agree &= compare_compact(data, size, expected, report);
+    }
+
+    struct maze maze;
+    if (!load_from_memory(&maze, data, size, &options)) {
+        return report_mismatch(report, "reload", true, false);
+    }
+
+    // component labels against the reference search
+    bool connected = components_connected(maze.components);
+    agree &= report_mismatch(report, "components_connected", expected != FUZZ_NO_PATH, connected);
+
+    // blocked layout copy and its column check
+    struct tiled_grid grid;
+    if (tiled_grid_create(&grid, &maze, TILED_BLOCK_SHIFT, TILED_BLOCK_SHIFT)) {
+        agree &= report_mismatch(report, "tiled_col_alone_wall 64x64", col_alone_wall(&maze), tiled_col_alone_wall(&grid));
+        for (size_t y = 0; y < maze.height; y++) {
+            for (size_t x = 0; x < maze.width; x++) {
+                char value = grid.cells[tiled_index(&grid, x, y)].value;
+                if (value != maze.tiles[y][x].value) {
+                    agree &= report_mismatch(report, "tiled_grid_create copy", maze.tiles[y][x].value, value);
+                }
+            }
+        }
+        tiled_grid_destroy(&grid);
+    }
+
+    // multi-source BFS, marker 0 is the entrance and marker 1 the exit
+    struct multi_result result;
+    if (multi_solve(&maze, &result, false)) {
+        agree &= report_mismatch(report, "multi_solve", expected, result.distances[1]);
+        agree &= report_mismatch(report, "multi_solve symmetry", result.distances[1], result.distances[2]);
+        multi_result_destroy(&result);
+    }
+
+    // Dial's algorithm against brute-force Dijkstra, and against BFS when every cost is one
+    size_t marks = count_path_tiles(&maze);
+    size_t cost;
+    bool solved = solve_maze_weighted(&maze, &cost);
+    if (!solved) {
+        cost = FUZZ_NO_PATH;
+    }
+    if (maze.max_cost == MAZE_DEFAULT_COST) {
+        agree &= report_mismatch(report, "solve_maze_weighted", expected, cost);
+        if (solved) {
+            agree &= report_mismatch(report, "solve_maze_weighted path", expected + 1, count_path_tiles(&maze));
+        }
+    }
+    if (maze.width * maze.height <= FUZZ_ORACLE_CELLS) {
+        agree &= report_mismatch(report, "solve_maze_weighted dijkstra", reference_weighted_cost(&maze), cost);
+    }
+    // 'o' already in the input would be counted too
+    if (solved && marks == 0) {
+        agree &= report_mismatch(report, "solve_maze_weighted path cost", cost, marked_path_cost(&maze));
+    }
+    maze_destroy(&maze);
+
+    // the external solver only takes walls, markers and spaces, it must refuse the rest
+    size_t marked;
+    size_t length;
+    extmem_run(data, size, &length, &marked);
+    if (!extmem_applies(data, size)) {
+        agree &= report_mismatch(report, "extmem_solve charset", FUZZ_NO_PATH, length);
+    } else {
+        agree &= report_mismatch(report, "extmem_solve", expected, length);
+        if (length != FUZZ_NO_PATH) {
+            agree &= report_mismatch(report, "extmem_solve path", expected + 1, marked);
+        }
+    }
+    return agree;
+}
+
+// every entry of the multi-source distance matrix against a search for that pair alone
+static bool compare_multi(const char *data, size_t size, FILE *report)
+{
+    struct maze_options options = { .allow_many_markers = true, .threads = 1, .reference_checks = false };
+    struct maze maze;
+    if (!load_from_memory(&maze, data, size, &options)) {
+        return true;
+    }
+    size_t n = maze.num_markers;
+    size_t *expected = (size_t *) malloc(n * n * sizeof(size_t));
+    if (expected == NULL) {
+        maze_destroy(&maze);
+        return true;
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            struct maze_path path;
+            expected[i * n + j] = FUZZ_NO_PATH;
+            if (maze_find_path(&maze, maze.markers[i], maze.markers[j], &path)) {
+                expected[i * n + j] = path.length;
+                maze_path_destroy(&path);
+            }
+        }
+    }
+
+    bool agree = true;
+    struct multi_result result;
+    if (multi_solve(&maze, &result, true)) {
+        for (size_t k = 0; k < n * n; k++) {
+            size_t distance = result.distances[k] == MULTI_UNREACHABLE ? FUZZ_NO_PATH : result.distances[k];
+            agree &= report_mismatch(report, "multi_solve pair", expected[k], distance);
+        }
+        multi_result_destroy(&result);
+    }
+    free(expected);
+    maze_destroy(&maze);
+    return agree;
+}
+
+/*
+ * Runs every engine on one input and compares against the reference.
+ * Returns false and describes the disagreements on report (may be NULL)
+ * if any engine differs.
+ */
+bool fuzz_check_input(const char *data, size_t size, FILE *report)
+{
+    assert(data != NULL || size == 0);
+
+    struct maze maze;
+    struct maze_options reference = { .allow_many_markers = false, .threads = 1, .reference_checks = true };
+    bool expected = load_from_memory(&maze, data, size, &reference);
+    if (expected) {
+        maze_destroy(&maze);
+    }
+
+    // validators: labeling in one and several stripes, and the multi-marker loader
+    bool agree = true;
+    size_t thread_counts[3] = { 1, 2, 5 };
+    for (int i = 0; i < 3; i++) {
+        struct maze_options options = { .allow_many_markers = false, .threads = thread_counts[i], .reference_checks = false };
+        bool valid = load_from_memory(&maze, data, size, &options);
+        if (valid) {
+            maze_destroy(&maze);
+        }
+        agree &= report_mismatch(report, "maze_create verdict", expected, valid);
+    }
+    size_t markers = 0;
+    for (size_t i = 0; i < size; i++) {
+        markers += data[i] == 'X';
+    }
+    if (markers == 2) {
+        struct maze_options options = { .allow_many_markers = true, .threads = 1, .reference_checks = false };
+        bool valid = load_from_memory(&maze, data, size, &options);
+        if (valid) {
+            maze_destroy(&maze);
+        }
+        agree &= report_mismatch(report, "maze_create multi verdict", expected, valid);
+    }
+    if (markers > 2) {
+        agree &= compare_multi(data, size, report);
+    }
+
+    if (compact_applies(data, size)) {
+        struct maze_path path;
+        size_t marked;
+        enum compact_status status = compact_run(data, size, &path, &marked);
+        if (status == COMPACT_OK) {
+            maze_path_destroy(&path);
+        }
+        agree &= report_mismatch(report, "compact_solve verdict", expected, status != COMPACT_INVALID);
+    }
+    // valid mazes are solved by extmem_solve in compare_valid_maze
+    if (!expected && extmem_applies(data, size)) {
+        size_t length;
+        size_t marked;
+        enum extmem_status status = extmem_run(data, size, &length, &marked);
+        agree &= report_mismatch(report, "extmem_solve verdict", false, status != EXTMEM_INVALID);
+    }
+
+    if (agree && expected) {
+        agree = compare_valid_maze(data, size, report);
+    }
+    return agree;
+}
+
+/* --- input generation --- */
+
+static char *generate_text(size_t cols, size_t rows, uint64_t seed, size_t *size)
+{
+    char *text = NULL;
+    FILE *stream = open_memstream(&text, size);
+    if (stream == NULL) {
+        return NULL;
+    }
+    bool ok = maze_generate(stream, cols, rows, seed);
+    fclose(stream);
+    if (!ok) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+// an open room, the widest BFS frontier a maze of this size can have
+static char *room_text(size_t width, size_t height, size_t *size)
+{
+    char *text = (char *) malloc((width + 1) * height);
+    if (text == NULL) {
+        return NULL;
+    }
+    for (size_t y = 0; y < height; y++) {
+        char *row = text + y * (width + 1);
+        for (size_t x = 0; x < width; x++) {
+            row[x] = (y == 0 || y == height - 1 || x == 0 || x == width - 1) ? '#' : ' ';
+        }
+        row[width] = '\n';
+    }
+    text[width + 1] = 'X';
+    text[(height - 2) * (width + 1) + width - 1] = 'X';
+    *size = (width + 1) * height;
+    return text;
+}
+
+// turns about a third of the open tiles into terrain digits
+static void add_terrain(char *text, size_t size, uint64_t *state)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] == ' ' && maze_next_random(state) % 3 == 0) {
+            text[i] = (char) ('1' + maze_next_random(state) % 9);
+        }
+    }
+}
+
+// extra 'X' markers for the multi-marker mode, the single-path loaders must refuse them
+static void add_markers(char *text, size_t size, uint64_t *state)
+{
+    size_t extra = 1 + maze_next_random(state) % 6;
+    for (size_t i = 0; i < size && extra > 0; i++) {
+        if (text[i] == ' ' && maze_next_random(state) % 8 == 0) {
+            text[i] = 'X';
+            extra--;
+        }
+    }
+}
+
+// small edits that keep most of the structure: replace, delete, insert, truncate
+static size_t mutate(char *text, size_t size, size_t capacity, uint64_t *state)
+{
+    static const char alphabet[] = "# X\n5o";
+    size_t edits = maze_next_random(state) % 4;
+    for (size_t e = 0; e < edits && size > 0; e++) {
+        size_t pos = maze_next_random(state) % size;
+        char c = alphabet[maze_next_random(state) % (sizeof(alphabet) - 1)];
+        switch (maze_next_random(state) % 8) {
+        case 0:
+            memmove(text + pos, text + pos + 1, size - pos - 1);
+            size--;
+            break;
+        case 1:
+            if (size < capacity) {
+                memmove(text + pos + 1, text + pos, size - pos);
+                text[pos] = c;
+                size++;
+            }
+            break;
+        case 2:
+            size = pos + 1;
+            break;
+        default:
+            text[pos] = c;
+            break;
+        }
+    }
+    return size;
+}
+
+/*
+ * Checks 'iterations' generated mazes, most of them mutated. Failing inputs
+ * are printed to report. Returns false if any engine disagreed.
+ */
+bool fuzz_run(size_t iterations, uint64_t seed, FILE *report)
+{
+    assert(report != NULL);
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    size_t failures = 0;
+    int saved = silence_stderr();
+
+    for (size_t i = 0; i < iterations; i++) {
+        size_t cols = 1 + maze_next_random(&state) % 12;
+        size_t rows = 1 + maze_next_random(&state) % 12;
+        size_t size;
+        char *text = maze_next_random(&state) % 5 == 0
+                ? room_text(3 + cols * 2, 3 + rows * 2, &size)
+                : generate_text(cols, rows, maze_next_random(&state), &size);
+        char *input = (char *) malloc(size + 8);
+        if (text == NULL || input == NULL) {
+            free(text);
+            free(input);
+            restore_stderr(saved);
+            return false;
+        }
+        memcpy(input, text, size);
+        if (maze_next_random(&state) % 4 == 0) {
+            add_terrain(input, size, &state);
+        }
+        if (maze_next_random(&state) % 6 == 0) {
+            add_markers(input, size, &state);
+        }
+        size_t input_size = maze_next_random(&state) % 4 == 0 ? size : mutate(input, size, size + 8, &state);
+
+        if (!fuzz_check_input(input, input_size, report)) {
+            failures++;
+            fprintf(report, "input %zu:\n%.*s\n---\n", i, (int) input_size, input);
+        }
+        free(input);
+        free(text);
+    }
+    restore_stderr(saved);
+    fprintf(report, "%zu inputs, %zu failures\n", iterations, failures);
+    return failures == 0;
+}
+
+/* --- throughput mode --- */
+
+struct perf_engine
+{
+    const char *name;
+    bool (*run)(const char *data, size_t size); // false if the engine does not apply to the input
+};
+
+static bool perf_load_threads(const char *data, size_t size, size_t threads, bool reference_checks)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = false, .threads = threads, .reference_checks = reference_checks };
+    if (load_from_memory(&maze, data, size, &options)) {
+        maze_destroy(&maze);
+    }
+    return true;
+}
+
+static bool perf_load(const char *data, size_t size)
+{
+    return perf_load_threads(data, size, 1, false);
+}
+
+static bool perf_load_4_threads(const char *data, size_t size)
+{
+    return perf_load_threads(data, size, 4, false);
+}
+
+static bool perf_load_reference(const char *data, size_t size)
+{
+    return perf_load_threads(data, size, 1, true);
+}
+
+static bool perf_solve_reference(const char *data, size_t size)
+{
+    reference_path_length(data, size);
+    return true;
+}
+
+static bool perf_solve(const char *data, size_t size)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    if (load_from_memory(&maze, data, size, &options)) {
+        solve_maze(&maze);
+        maze_destroy(&maze);
+    }
+    return true;
+}
+
+static bool perf_solve_path(const char *data, size_t size)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    if (load_from_memory(&maze, data, size, &options)) {
+        struct maze_path path;
+        if (maze_solve_path(&maze, &path)) {
+            maze_path_destroy(&path);
+        }
+        maze_destroy(&maze);
+    }
+    return true;
+}
+
+static bool perf_kernel(const char *data, size_t size, size_t index_bytes)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    bool fits = true;
+    if (load_from_memory(&maze, data, size, &options)) {
+        size_t length;
+        fits = index_bytes >= kernel_index_bytes(&maze);
+        if (fits) {
+            kernel_solve_length(&maze, index_bytes, &length);
+        }
+        maze_destroy(&maze);
+    }
+    return fits;
+}
+
+static bool perf_kernel_u16(const char *data, size_t size)
+{
+    return perf_kernel(data, size, 2);
+}
+
+static bool perf_kernel_u32(const char *data, size_t size)
+{
+    return perf_kernel(data, size, 4);
+}
+
+static bool perf_kernel_u64(const char *data, size_t size)
+{
+    return perf_kernel(data, size, 8);
+}
+
+static bool perf_dial(const char *data, size_t size)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    if (load_from_memory(&maze, data, size, &options)) {
+        size_t cost;
+        solve_maze_weighted(&maze, &cost);
+        maze_destroy(&maze);
+    }
+    return true;
+}
+
+static bool perf_multi(const char *data, size_t size)
+{
+    struct maze maze;
+    struct maze_options options = { .allow_many_markers = true, .threads = 1, .reference_checks = false };
+    if (load_from_memory(&maze, data, size, &options)) {
+        struct multi_result result;
+        if (multi_solve(&maze, &result, true)) {
+            multi_result_destroy(&result);
+        }
+        maze_destroy(&maze);
+    }
+    return true;
+}
+
+static bool perf_compact(const char *data, size_t size)
+{
+    struct maze_path path;
+    size_t marked;
+    if (compact_run(data, size, &path, &marked) == COMPACT_OK) {
+        maze_path_destroy(&path);
+    }
+    return true;
+}
+
+static bool perf_extmem(const char *data, size_t size)
+{
+    size_t length;
+    size_t marked;
+    extmem_run(data, size, &length, &marked);
+    return true;
+}
+
+static const struct perf_engine engines[] = {
+    { "maze_create", perf_load },
+    { "maze_create 4 threads", perf_load_4_threads },
+    { "maze_create reference", perf_load_reference },
+    { "solve_maze reference", perf_solve_reference },
+    { "solve_maze", perf_solve },
+    { "maze_solve_path", perf_solve_path },
+    { "kernel_solve_length u16", perf_kernel_u16 },
+    { "kernel_solve_length u32", perf_kernel_u32 },
+    { "kernel_solve_length u64", perf_kernel_u64 },
+    { "solve_maze_weighted", perf_dial },
+    { "multi_solve", perf_multi },
+    { "compact_solve", perf_compact },
+    { "extmem_solve", perf_extmem },
+};
+
+// NAN if the engine does not apply to the input
+static double time_engine(const struct perf_engine *engine, const char *data, size_t size)
+{
+    double best = INFINITY;
+    for (int r = 0; r < FUZZ_PERF_REPEATS; r++) {
+        double start = maze_now_seconds();
+        if (!engine->run(data, size)) {
+            return NAN;
+        }
+        double elapsed = maze_now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+/*
+ * Times every engine on corridor-heavy and open-room inputs of 'cells' and
+ * FUZZ_PERF_GROWTH times as many cells. An engine whose time per cell grows
+ * by more than FUZZ_PERF_LIMIT is flagged. Returns false if any was flagged.
+ */
+bool fuzz_perf(size_t cells, FILE *report)
+{
+    assert(report != NULL);
+    bool linear = true;
+    int saved = silence_stderr();
+
+    fprintf(report, "%-8s %-24s %12s %12s %8s\n", "input", "engine", "ns/cell", "ns/cell x4", "growth");
+    for (int shape = 0; shape < 2; shape++) {
+        char *texts[2];
+        size_t sizes[2];
+        for (int i = 0; i < 2; i++) {
+            size_t side = (size_t) sqrt((double) cells * (i == 0 ? 1 : FUZZ_PERF_GROWTH));
+            texts[i] = shape == 0 ? generate_text(side / 2, side / 2, 1, &sizes[i]) : room_text(side, side, &sizes[i]);
+        }
+        if (texts[0] == NULL || texts[1] == NULL) {
+            free(texts[0]);
+            free(texts[1]);
+            restore_stderr(saved);
+            return false;
+        }
+        for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+            double small = time_engine(&engines[e], texts[0], sizes[0]) * 1e9 / sizes[0];
+            double large = time_engine(&engines[e], texts[1], sizes[1]) * 1e9 / sizes[1];
+            if (isnan(small) || isnan(large)) {
+                // e.g. the 16-bit kernel on inputs past its index range, nothing to compare
+                fprintf(report, "%-8s %-24s %12.2f %12.2f %8s\n", shape == 0 ? "maze" : "room", engines[e].name,
+                        small, large, "n/a");
+                continue;
+            }
+            double growth = large / small;
+            fprintf(report, "%-8s %-24s %12.2f %12.2f %7.2fx%s\n", shape == 0 ? "maze" : "room", engines[e].name,
+                    small, large, growth, growth > FUZZ_PERF_LIMIT ? "  SUPERLINEAR" : "");
+            linear &= growth <= FUZZ_PERF_LIMIT;
+        }
+        free(texts[0]);
+        free(texts[1]);
+    }
+    restore_stderr(saved);
+    return linear;
+}
+
+#ifdef MAZE_LIBFUZZER
+// libFuzzer entry point, built by 'make fuzz'
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (!fuzz_check_input((const char *) data, size, stdout)) {
+        abort();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,13 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+bool fuzz_check_input(const char *data, size_t size, FILE *report);
+bool fuzz_run(size_t iterations, uint64_t seed, FILE *report);
+bool fuzz_perf(size_t cells, FILE *report);
+
+#endif // FUZZ_H
@@ -0,0 +1,82 @@
+#include "gen.h"
+
+#include "maze.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/*
+ * Maze generator used for benchmark inputs.
+ * Carves a perfect maze (randomized depth-first search) over cols x rows
+ * rooms and writes it as text: (2 * cols + 1) x (2 * rows + 1) characters
+ * with the entrance on the left border and the exit on the right border.
+ * Walls of a perfect maze form a single connected tree, so the output
+ * always passes maze_create validation.
+ */
+
+bool maze_generate(FILE *output_file, size_t cols, size_t rows, uint64_t seed)
+{
+    assert(output_file != NULL);
+    assert(cols > 0 && rows > 0);
+
+    size_t width = 2 * cols + 1;
+    size_t height = 2 * rows + 1;
+    char *grid = (char *) malloc(width * height);
+    size_t *stack = (size_t *) malloc(cols * rows * sizeof(size_t));
+    if (grid == NULL || stack == NULL) {
+        free(grid);
+        free(stack);
+        return false;
+    }
+    for (size_t i = 0; i < width * height; i++) {
+        grid[i] = '#';
+    }
+
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    size_t top = 0;
+    stack[top++] = 0;
+    grid[width + 1] = ' ';
+
+    while (top > 0) {
+        size_t room = stack[top - 1];
+        size_t rx = room % cols;
+        size_t ry = room / cols;
+
+        // collect unvisited neighbouring rooms
+        int candidates[4];
+        int count = 0;
+        for (int d = 0; d < 4; d++) {
+            long nx = (long) rx + maze_dx[d];
+            long ny = (long) ry + maze_dy[d];
+            if (nx < 0 || ny < 0 || nx >= (long) cols || ny >= (long) rows) {
+                continue;
+            }
+            if (grid[(2 * ny + 1) * width + 2 * nx + 1] == '#') {
+                candidates[count++] = d;
+            }
+        }
+        if (count == 0) {
+            top--;
+            continue;
+        }
+
+        int d = candidates[maze_next_random(&state) % count];
+        size_t nx = rx + maze_dx[d];
+        size_t ny = ry + maze_dy[d];
+        grid[(2 * ry + 1 + maze_dy[d]) * width + 2 * rx + 1 + maze_dx[d]] = ' ';
+        grid[(2 * ny + 1) * width + 2 * nx + 1] = ' ';
+        stack[top++] = ny * cols + nx;
+    }
+
+    grid[width] = 'X';
+    grid[(height - 2) * width + width - 1] = 'X';
+
+    for (size_t y = 0; y < height; y++) {
+        fwrite(grid + y * width, 1, width, output_file);
+        fputc('\n', output_file);
+    }
+
+    free(grid);
+    free(stack);
+    return true;
+}
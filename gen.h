@@ -0,0 +1,11 @@
+#ifndef GEN_H
+#define GEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+bool maze_generate(FILE *output_file, size_t cols, size_t rows, uint64_t seed);
+
+#endif // GEN_H
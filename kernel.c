@@ -0,0 +1,265 @@
+#include "kernel.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Specialized BFS kernels for the fixed 4-neighbour grid.
+ * The maze is copied into one byte per cell with a ring of blocked sentinels
+ * around it, so the neighbours of a cell are cell - stride, cell + 1,
+ * cell + stride and cell - 1 and no move needs a bounds check. The same byte
+ * records the move that reached the cell, which leaves the queue as the only
+ * array sized by the index type. The kernel body is generated once per index
+ * width and the smallest type that addresses the padded grid is used.
+ *
+ * Neighbours are tried Up, Right, Down, Left like the reference solver, so
+ * both find the same path. The recorded moves become a packed maze_path.
+ */
+
+enum kernel_state
+{
+    KERNEL_BLOCKED = 0, // wall, sentinel or past the end of a short row
+    KERNEL_OPEN,
+    KERNEL_MOVED_UP,    // reached from the cell below; the moves follow enum path_move
+    KERNEL_MOVED_RIGHT,
+    KERNEL_MOVED_DOWN,
+    KERNEL_MOVED_LEFT,
+    KERNEL_START,
+};
+
+struct kernel_grid
+{
+    unsigned char *state; // (width + 2) x (height + 2) cells of enum kernel_state
+    size_t stride;
+    size_t cells;
+    size_t start;
+    size_t target;
+};
+
+typedef bool (*bfs_kernel)(unsigned char *state, size_t stride, size_t start, size_t target, void *queue_memory);
+
+// tries one neighbour; returns from the kernel as soon as the target is reached
+#define KERNEL_VISIT(index_t, next_cell, moved) \
+    do { \
+        index_t next = (index_t) (next_cell); \
+        if (state[next] == KERNEL_OPEN) { \
+            state[next] = (moved); \
+            if ((size_t) next == target) { \
+                return true; \
+            } \
+            queue[tail++] = next; \
+        } \
+    } while (0)
+
+// every cell enters the queue at most once, so it needs no wrap-around
+#define DEFINE_BFS_KERNEL(name, index_t) \
+    static bool name(unsigned char *state, size_t stride, size_t start, size_t target, void *queue_memory) \
+    { \
+        index_t *queue = (index_t *) queue_memory; \
+        index_t step = (index_t) stride; \
+        size_t head = 0; \
+        size_t tail = 0; \
+        state[start] = KERNEL_START; \
+        queue[tail++] = (index_t) start; \
+        while (head < tail) { \
+            index_t cell = queue[head++]; \
+            KERNEL_VISIT(index_t, cell - step, KERNEL_MOVED_UP); \
+            KERNEL_VISIT(index_t, cell + 1, KERNEL_MOVED_RIGHT); \
+            KERNEL_VISIT(index_t, cell + step, KERNEL_MOVED_DOWN); \
+            KERNEL_VISIT(index_t, cell - 1, KERNEL_MOVED_LEFT); \
+        } \
+        return false; \
+    }
+
+DEFINE_BFS_KERNEL(bfs_kernel_u16, uint16_t)
+DEFINE_BFS_KERNEL(bfs_kernel_u32, uint32_t)
+DEFINE_BFS_KERNEL(bfs_kernel_u64, uint64_t)
+
+struct kernel_variant
+{
+    size_t index_bytes;
+    size_t max_cells; // largest padded grid the index type can address
+    bfs_kernel run;
+};
+
+static const struct kernel_variant variants[] = {
+    { sizeof(uint16_t), UINT16_MAX, bfs_kernel_u16 },
+    { sizeof(uint32_t), UINT32_MAX, bfs_kernel_u32 },
+    { sizeof(uint64_t), SIZE_MAX, bfs_kernel_u64 },
+};
+
+static size_t padded_cells(const struct maze *maze)
+{
+    return (maze->width + 2) * (maze->height + 2);
+}
+
+static const struct kernel_variant *pick_variant(const struct maze *maze, size_t index_bytes)
+{
+    size_t cells = padded_cells(maze);
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        if (cells <= variants[i].max_cells
+                && (index_bytes == KERNEL_AUTO_INDEX || index_bytes == variants[i].index_bytes)) {
+            return &variants[i];
+        }
+    }
+    return NULL;
+}
+
+static bool in_box(const struct maze *maze, struct position pos)
+{
+    return pos.x >= 0 && (size_t) pos.x < maze->width && pos.y >= 0 && (size_t) pos.y < maze->height;
+}
+
+static size_t grid_cell(const struct kernel_grid *grid, struct position pos)
+{
+    return ((size_t) pos.y + 1) * grid->stride + (size_t) pos.x + 1;
+}
+
+// maze_is_walkable read a row at a time, everything else stays KERNEL_BLOCKED
+static bool kernel_grid_create(struct kernel_grid *grid, const struct maze *maze, struct position from, struct position to)
+{
+    grid->stride = maze->width + 2;
+    grid->cells = padded_cells(maze);
+    grid->state = (unsigned char *) calloc(grid->cells, 1);
+    if (grid->state == NULL) {
+        return false;
+    }
+    for (size_t y = 0; y < maze->height; y++) {
+        unsigned char *row = grid->state + (y + 1) * grid->stride + 1;
+        const struct tile *tiles = maze->tiles[y];
+        size_t limit = maze->line_lengths[y] < maze->width ? maze->line_lengths[y] : maze->width;
+        for (size_t x = 0; x < limit; x++) {
+            row[x] = tiles[x].value != '#' ? KERNEL_OPEN : KERNEL_BLOCKED;
+        }
+    }
+    grid->start = grid_cell(grid, from);
+    grid->target = grid_cell(grid, to);
+    return true;
+}
+
+/*
+ * Runs the BFS from 'from' to 'to'. Only reads the maze, all search state
+ * lives in grid, so searches on one maze may run concurrently. On success
+ * grid->state keeps the recorded moves and the caller frees it.
+ */
+static bool kernel_search(const struct maze *maze, struct position from, struct position to, size_t index_bytes, struct kernel_grid *grid)
+{
+    // positions outside the wall box are never walkable, the padded grid has no room for them
+    if (!in_box(maze, from) || !in_box(maze, to)) {
+        return false;
+    }
+    const struct kernel_variant *variant = pick_variant(maze, index_bytes);
+    if (variant == NULL) {
+        return false;
+    }
+
+    if (!kernel_grid_create(grid, maze, from, to)) {
+        fprintf(stderr, "memory allocation failed\n");
+        return false;
+    }
+    void *queue = malloc(grid->cells * variant->index_bytes);
+    if (queue == NULL) {
+        fprintf(stderr, "memory allocation failed\n");
+        free(grid->state);
+        return false;
+    }
+
+    bool found = grid->start == grid->target;
+    if (!found) {
+        found = variant->run(grid->state, grid->stride, grid->start, grid->target, queue);
+    }
+    free(queue);
+    if (!found) {
+        free(grid->state);
+    }
+    return found;
+}
+
+// the cell a recorded move came from
+static size_t step_back(const struct kernel_grid *grid, size_t cell)
+{
+    switch (grid->state[cell]) {
+    case KERNEL_MOVED_UP:
+        return cell + grid->stride;
+    case KERNEL_MOVED_RIGHT:
+        return cell - 1;
+    case KERNEL_MOVED_DOWN:
+        return cell - grid->stride;
+    default:
+        return cell + 1;
+    }
+}
+
+static size_t trace_length(const struct kernel_grid *grid)
+{
+    size_t steps = 0;
+    for (size_t cell = grid->target; cell != grid->start; cell = step_back(grid, cell)) {
+        steps++;
+    }
+    return steps;
+}
+
+/*
+ * Fills start, end, length and the packed moves of path with the shortest
+ * route from 'from' to 'to'; checkpoints are left to the caller. Never writes
+ * to the maze. Returns false if there is no path or memory runs out.
+ */
+bool kernel_find_path(const struct maze *maze, struct position from, struct position to, size_t index_bytes, struct maze_path *path)
+{
+    assert(maze != NULL);
+    assert(path != NULL);
+    struct kernel_grid grid;
+    if (!kernel_search(maze, from, to, index_bytes, &grid)) {
+        return false;
+    }
+
+    path->start = from;
+    path->end = to;
+    path->length = trace_length(&grid);
+    path->moves = (uint8_t *) calloc(path->length / 4 + 1, 1);
+    path->checkpoints = NULL;
+    path->num_checkpoints = 0;
+    if (path->moves == NULL) {
+        fprintf(stderr, "memory allocation failed\n");
+        free(grid.state);
+        return false;
+    }
+    // the walk back yields moves last to first, enum path_move follows the state order
+    size_t cell = grid.target;
+    for (size_t i = path->length; i-- > 0;) {
+        unsigned move = (unsigned) (grid.state[cell] - KERNEL_MOVED_UP);
+        path->moves[i / 4] |= (uint8_t) (move << (2 * (i % 4)));
+        cell = step_back(&grid, cell);
+    }
+    free(grid.state);
+    return true;
+}
+
+/*
+ * Stores the number of steps of the shortest path in length without touching
+ * the maze. index_bytes forces a kernel (2, 4 or 8), KERNEL_AUTO_INDEX picks
+ * the smallest one. Returns false if there is no path or the forced index
+ * type cannot address the maze.
+ */
+bool kernel_solve_length(const struct maze *maze, size_t index_bytes, size_t *length)
+{
+    assert(maze != NULL);
+    assert(length != NULL);
+    struct kernel_grid grid;
+    if (!kernel_search(maze, maze->entrance, maze->exit, index_bytes, &grid)) {
+        return false;
+    }
+    *length = trace_length(&grid);
+    free(grid.state);
+    return true;
+}
+
+// index width the automatic choice uses for this maze
+size_t kernel_index_bytes(const struct maze *maze)
+{
+    assert(maze != NULL);
+    const struct kernel_variant *variant = pick_variant(maze, KERNEL_AUTO_INDEX);
+    return variant != NULL ? variant->index_bytes : 0;
+}
@@ -0,0 +1,17 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "maze.h"
+#include "path.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// 0 picks the smallest index type the padded grid fits in
+#define KERNEL_AUTO_INDEX 0
+
+bool kernel_find_path(const struct maze *maze, struct position from, struct position to, size_t index_bytes, struct maze_path *path);
+bool kernel_solve_length(const struct maze *maze, size_t index_bytes, size_t *length);
+size_t kernel_index_bytes(const struct maze *maze);
+
+#endif // KERNEL_H
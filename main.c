@@ -1,5 +1,12 @@
+#include "batch.h"
+#include "bench.h"
+#include "compact.h"
+#include "extmem.h"
+#include "fuzz.h"
 #include "maze.h"
-#include "queue.h"
+#include "multi.h"
+#include "path.h"
+#include "solve.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,126 +15,84 @@
 #define UNUSED(X) ((void) (X))
 
 /*
- * Finds the shortest path from entrance to exit using BFS.
- * Marks the path with 'o' characters in the maze structure.
- * Returns true if a path is found, false otherwise.
+ * Main entry point. Handles arguments and switches between 'check' and 'solve' modes.
  */
-bool solve_maze(struct maze *maze)
+int main(int argc, char *argv[])
 {
-    assert(maze != NULL);
-    struct queue queue_struct;
-    queue_init(&queue_struct);
-
-    // Arrays to keep track of visited nodes and path reconstruction
-    bool visited[maze->height][maze->width];
-    struct position predecessors[maze->height][maze->width];
-
-    // Mark entrance as part of the path initially
-    maze->tiles[maze->entrance.y][maze->entrance.x].value = 'o';
-
-    // Initialize visited array and predecessors
-    for (size_t i = 0; i < maze->height; i++) {
-        for (size_t j = 0; j < maze->width; j++) {
-            visited[i][j] = false;
-            predecessors[i][j].x = -1;
-            predecessors[i][j].y = -1;
+    /* --- BENCHMARK MODE --- */
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        size_t cells = argc >= 3 ? strtoull(argv[2], NULL, 10) : 4000000;
+        if (cells < 16) {
+            fprintf(stderr, "Error: Invalid benchmark size.\n");
+            return EXIT_FAILURE;
         }
+        return bench_run(cells, stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    visited[maze->entrance.y][maze->entrance.x] = true;
-    queue_insert(&queue_struct, (struct node){ .pos = maze->entrance, .parent = NULL });
-
-    // Direction vectors for moving Up, Right, Down, Left
-    int dx[4] = { 0, 1, 0, -1 };
-    int dy[4] = { -1, 0, 1, 0 };
-
-    while (!queue_is_empty(&queue_struct)) {
-        struct node current = queue_pop(&queue_struct);
-
-        // Check if we reached the exit
-        if (current.pos.x == maze->exit.x && current.pos.y == maze->exit.y) {
-            struct position pos = current.pos;
-            
-            // Backtrack from exit to entrance to mark the path
-            while (pos.x != maze->entrance.x || pos.y != maze->entrance.y) {
-                maze->tiles[pos.y][pos.x].value = 'o';
-                pos = predecessors[pos.y][pos.x];
-            }
-            queue_free(&queue_struct);
-            return true;
-        }
-
-        // Explore neighbors
-        for (int i = 0; i < 4; i++) {
-            struct position next = { current.pos.x + dx[i], current.pos.y + dy[i] };
-            
-            if (maze_is_within_bounds(maze, next) && 
-                maze->tiles[next.y][next.x].value != '#' && 
-                !visited[next.y][next.x]) {
-                
-                visited[next.y][next.x] = true;
-                predecessors[next.y][next.x] = current.pos;
-                queue_insert(&queue_struct, (struct node){ .pos = next, .parent = &current });
-            }
-        }
+    /* --- DIFFERENTIAL FUZZING MODES --- */
+    if (argc >= 2 && strcmp(argv[1], "fuzz") == 0) {
+        size_t iterations = argc >= 3 ? strtoull(argv[2], NULL, 10) : 10000;
+        uint64_t seed = argc >= 4 ? strtoull(argv[3], NULL, 10) : 1;
+        return fuzz_run(iterations, seed, stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
-    
-    queue_free(&queue_struct);
-    return false;
-}
-
-/*
- * Prints the solved maze to the specified output file.
- * Handles trimming of leading empty columns to match the assignment format.
- */
-void maze_print(struct maze *maze, FILE *output_file)
-{
-    assert(maze != NULL);
-    assert(output_file != NULL);
-    
-    // Find the leftmost column that contains actual maze content (not just spaces)
-    size_t leftmost_non_space_col = maze->width;
-
-    for (size_t i = 0; i < maze->height; i++) {
-        for (size_t j = 0; j < maze->width; j++) {
-            if (maze->tiles[i][j].value != ' ') {
-                if (j < leftmost_non_space_col) {
-                    leftmost_non_space_col = j;
-                }
-                break;
-            }
+    if (argc >= 2 && strcmp(argv[1], "fuzz-perf") == 0) {
+        size_t cells = argc >= 3 ? strtoull(argv[2], NULL, 10) : 60000;
+        if (cells < 16) {
+            fprintf(stderr, "Error: Invalid benchmark size.\n");
+            return EXIT_FAILURE;
         }
+        return fuzz_perf(cells, stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
-    
-    // Update line lengths to ensure correct trimming from the right
-    count_Llength(maze);
-
-    for (size_t i = 0; i < maze->height; i++) {
-        // Start printing from the first useful column
-        for (size_t j = leftmost_non_space_col; j < maze->line_lengths[i]; j++) {
-            if (maze->tiles[i][j].value == '\n') {
-                continue;
-            }
-            fprintf(output_file, "%c", maze->tiles[i][j].value);
+    if (argc >= 3 && strcmp(argv[1], "fuzz-one") == 0) {
+        // AFL target: abort on any disagreement so it is recorded as a crash
+        FILE *input_file = fopen(argv[2], "rb");
+        if (input_file == NULL) {
+            fprintf(stderr, "Error: Cannot open input file.\n");
+            return EXIT_FAILURE;
+        }
+        char *data = NULL;
+        size_t size = 0;
+        FILE *stream = open_memstream(&data, &size);
+        for (int c; stream != NULL && (c = fgetc(input_file)) != EOF;) {
+            fputc(c, stream);
         }
-        fprintf(output_file, "\n");
+        fclose(input_file);
+        if (stream == NULL) {
+            return EXIT_FAILURE;
+        }
+        fclose(stream);
+        bool agree = fuzz_check_input(data, size, stdout);
+        free(data);
+        if (!agree) {
+            abort();
+        }
+        return EXIT_SUCCESS;
     }
-}
 
-/*
- * Main entry point. Handles arguments and switches between 'check' and 'solve' modes.
- */
-int main(int argc, char *argv[])
-{
     // Argument count check (minimal check, logic mostly relies on argv[1])
     if (argc < 3) {
-        fprintf(stderr, "Usage: ./maze check INPUT_FILE\n");
+        fprintf(stderr, "Usage: ./maze check INPUT_FILE [--threads=N]\n");
         fprintf(stderr, "       ./maze solve INPUT_FILE OUTPUT_FILE\n");
+        fprintf(stderr, "       ./maze path INPUT_FILE [OUTPUT_FILE]\n");
+        fprintf(stderr, "       ./maze multi INPUT_FILE [OUTPUT_FILE]\n");
+        fprintf(stderr, "       ./maze solve-ext INPUT_FILE [OUTPUT_FILE] [--mem=BYTES] [--tmp=DIR]\n");
+        fprintf(stderr, "       ./maze solve-compact INPUT_FILE [OUTPUT_FILE]\n");
+        fprintf(stderr, "       ./maze convert INPUT_FILE OUTPUT_FILE\n");
+        fprintf(stderr, "       ./maze batch OUTPUT_DIR INPUT_FILE... [--readers=N] [--depth=N]\n");
+        fprintf(stderr, "       ./maze bench [CELLS]\n");
+        fprintf(stderr, "       ./maze fuzz [ITERATIONS] [SEED] | fuzz-one FILE | fuzz-perf [CELLS]\n");
         return EXIT_FAILURE;
     }
 
     if (strcmp(argv[1], "check") == 0) {
         /* --- CHECK MODE --- */
+        struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+        for (int i = 3; i < argc; i++) {
+            if (strncmp(argv[i], "--threads=", 10) == 0) {
+                options.threads = strtoull(argv[i] + 10, NULL, 10);
+            }
+        }
+
         FILE *file = fopen(argv[2], "r");
         if (file == NULL) {
             fprintf(stderr, "Error: Cannot open input file.\n");
@@ -135,7 +100,7 @@ int main(int argc, char *argv[])
         }
 
         struct maze maze;
-        if (!maze_create(&maze, file)) {
+        if (!maze_create_with_options(&maze, file, &options)) {
             fprintf(stderr, "Error: Invalid maze.\n");
             fclose(file);
             maze_destroy(&maze);
@@ -159,36 +124,258 @@ int main(int argc, char *argv[])
             return EXIT_FAILURE;
         }
 
+        struct solution solution;
+        enum solve_status status = solution_create(&solution, input_file);
+        fclose(input_file);
+        if (status == SOLVE_INVALID) {
+            fprintf(stderr, "Error: Invalid maze.\n");
+            return EXIT_FAILURE;
+        }
+        if (status == SOLVE_NO_SOLUTION) {
+            fprintf(stderr, "Error: No solution found.\n");
+            return EXIT_FAILURE; // Should technically exit with failure if not solvable?
+        }
+
+        FILE *output_file = fopen(argv[3], "w");
+        if (!output_file) {
+            fprintf(stderr, "Error: Cannot create output file.\n");
+            solution_destroy(&solution);
+            return EXIT_FAILURE;
+        }
+        bool printed = solution_print(&solution, output_file);
+        fclose(output_file);
+        // without terrain the cost is just the path length, the output stays as before
+        if (printed && solution.maze.max_cost != MAZE_DEFAULT_COST) {
+            fprintf(stdout, "Cost: %zu\n", solution.cost);
+        }
+        solution_destroy(&solution);
+        if (!printed) {
+            fprintf(stderr, "Error: Memory allocation failed.\n");
+            return EXIT_FAILURE;
+        }
+        
+    } else if (strcmp(argv[1], "path") == 0) {
+        /* --- PATH QUERY MODE --- */
+        FILE *input_file = fopen(argv[2], "r");
+        if (!input_file) {
+            fprintf(stderr, "Error: Cannot open input file.\n");
+            return EXIT_FAILURE;
+        }
+
         struct maze maze;
         if (!maze_create(&maze, input_file)) {
             fprintf(stderr, "Error: Invalid maze.\n");
             fclose(input_file);
-            maze_destroy(&maze); 
+            maze_destroy(&maze);
             return EXIT_FAILURE;
         }
         fclose(input_file);
 
-        if (solve_maze(&maze)) {
+        // the move list comes from an unweighted BFS, it is not the cheapest route over terrain
+        if (maze.max_cost != MAZE_DEFAULT_COST) {
+            fprintf(stderr, "Error: Terrain costs need the solve mode.\n");
+            maze_destroy(&maze);
+            return EXIT_FAILURE;
+        }
+
+        struct maze_path path;
+        if (!maze_solve_path(&maze, &path)) {
+            fprintf(stderr, "Error: No solution found.\n");
+            maze_destroy(&maze);
+            return EXIT_FAILURE;
+        }
+        fprintf(stdout, "Length: %zu\n", path.length);
+        maze_path_print_moves(&path, stdout);
+
+        if (argc >= 4) {
             FILE *output_file = fopen(argv[3], "w");
             if (!output_file) {
                 fprintf(stderr, "Error: Cannot create output file.\n");
+                maze_path_destroy(&path);
                 maze_destroy(&maze);
                 return EXIT_FAILURE;
             }
-            maze_print(&maze, output_file);
+            bool printed = maze_path_print(&maze, &path, output_file);
             fclose(output_file);
-        } else {
-            fprintf(stderr, "Error: No solution found.\n");
+            if (!printed) {
+                fprintf(stderr, "Error: Memory allocation failed.\n");
+                maze_path_destroy(&path);
+                maze_destroy(&maze);
+                return EXIT_FAILURE;
+            }
+        }
+        maze_path_destroy(&path);
+        maze_destroy(&maze);
+
+    } else if (strcmp(argv[1], "multi") == 0) {
+        /* --- MULTI-MARKER MODE --- */
+        FILE *input_file = fopen(argv[2], "r");
+        if (!input_file) {
+            fprintf(stderr, "Error: Cannot open input file.\n");
+            return EXIT_FAILURE;
+        }
+
+        struct maze maze;
+        struct maze_options options = { .allow_many_markers = true, .threads = 1 };
+        if (!maze_create_with_options(&maze, input_file, &options)) {
+            fprintf(stderr, "Error: Invalid maze.\n");
+            fclose(input_file);
             maze_destroy(&maze);
-            return EXIT_FAILURE; // Should technically exit with failure if not solvable?
+            return EXIT_FAILURE;
+        }
+        fclose(input_file);
+
+        // the labelled BFS counts steps, it cannot give the cheapest routes over terrain
+        if (maze.max_cost != MAZE_DEFAULT_COST) {
+            fprintf(stderr, "Error: Terrain costs need the solve mode.\n");
+            maze_destroy(&maze);
+            return EXIT_FAILURE;
+        }
+
+        // paths to the nearest marker are only drawn when an output file is requested
+        struct multi_result result;
+        if (!multi_solve(&maze, &result, argc >= 4)) {
+            fprintf(stderr, "Error: Memory allocation failed.\n");
+            maze_destroy(&maze);
+            return EXIT_FAILURE;
+        }
+        multi_result_print(&maze, &result, stdout);
+        multi_result_destroy(&result);
+
+        if (argc >= 4) {
+            FILE *output_file = fopen(argv[3], "w");
+            if (!output_file) {
+                fprintf(stderr, "Error: Cannot create output file.\n");
+                maze_destroy(&maze);
+                return EXIT_FAILURE;
+            }
+            maze_print(&maze, output_file);
+            fclose(output_file);
         }
 
         maze_destroy(&maze);
-        
+
+    } else if (strcmp(argv[1], "solve-ext") == 0) {
+        /* --- OUT-OF-CORE SOLVE MODE --- */
+        struct extmem_options options = { .memory_cap = EXTMEM_DEFAULT_MEMORY, .temp_dir = "/tmp" };
+        const char *output_path = NULL;
+        for (int i = 3; i < argc; i++) {
+            if (strncmp(argv[i], "--mem=", 6) == 0) {
+                options.memory_cap = strtoull(argv[i] + 6, NULL, 10);
+            } else if (strncmp(argv[i], "--tmp=", 6) == 0) {
+                options.temp_dir = argv[i] + 6;
+            } else {
+                output_path = argv[i];
+            }
+        }
+        if (options.memory_cap < EXTMEM_MIN_MEMORY) {
+            fprintf(stderr, "Error: Memory cap must be at least %zu bytes.\n", EXTMEM_MIN_MEMORY);
+            return EXIT_FAILURE;
+        }
+
+        struct extmem_stats stats;
+        enum extmem_status status = extmem_solve(argv[2], output_path, &options, &stats);
+        // nothing was searched when the input is refused up front
+        if (status == EXTMEM_CANNOT_READ || status == EXTMEM_INVALID || status == EXTMEM_NEEDS_TEXT) {
+            fprintf(stderr, "Error: %s\n", extmem_status_message(status));
+            return EXIT_FAILURE;
+        }
+        fprintf(stdout, "Levels: %llu\n", (unsigned long long) stats.levels);
+        fprintf(stdout, "I/O read: %llu bytes\n", (unsigned long long) stats.bytes_read);
+        fprintf(stdout, "I/O written: %llu bytes\n", (unsigned long long) stats.bytes_written);
+        if (status != EXTMEM_OK) {
+            fprintf(stderr, "Error: %s\n", extmem_status_message(status));
+            return EXIT_FAILURE;
+        }
+        fprintf(stdout, "Path length: %llu\n", (unsigned long long) stats.path_length);
+
+    } else if (strcmp(argv[1], "solve-compact") == 0) {
+        /* --- BIT-PACKED SOLVE MODE --- */
+        FILE *input_file = fopen(argv[2], "r");
+        if (!input_file) {
+            fprintf(stderr, "Error: Cannot open input file.\n");
+            return EXIT_FAILURE;
+        }
+        FILE *output_file = NULL;
+        if (argc >= 4) {
+            output_file = fopen(argv[3], "w");
+            if (!output_file) {
+                fprintf(stderr, "Error: Cannot create output file.\n");
+                fclose(input_file);
+                return EXIT_FAILURE;
+            }
+        }
+
+        struct compact_stats stats;
+        enum compact_status status = compact_solve(input_file, output_file, NULL, &stats);
+        fclose(input_file);
+        if (output_file != NULL && fclose(output_file) != 0 && status == COMPACT_OK) {
+            status = COMPACT_CANNOT_WRITE;
+        }
+        if (status == COMPACT_OK) {
+            fprintf(stdout, "Length: %zu\n", stats.path_length);
+        }
+        compact_print_stats(&stats, stdout);
+        if (status != COMPACT_OK) {
+            fprintf(stderr, "Error: %s\n", compact_status_message(status));
+            return EXIT_FAILURE;
+        }
+
+    } else if (strcmp(argv[1], "convert") == 0) {
+        /* --- TEXT TO BINARY CONVERSION --- */
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing output file argument.\n");
+            return EXIT_FAILURE;
+        }
+        struct extmem_stats stats;
+        if (!extmem_convert(argv[2], argv[3], &stats)) {
+            fprintf(stderr, "Error: Cannot convert maze.\n");
+            return EXIT_FAILURE;
+        }
+
+    } else if (strcmp(argv[1], "batch") == 0) {
+        /* --- PIPELINED BATCH MODE --- */
+        struct batch_options options = { .readers = BATCH_DEFAULT_READERS, .depth = BATCH_DEFAULT_DEPTH };
+        char **inputs = (char **) malloc(argc * sizeof(char *));
+        if (inputs == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed.\n");
+            return EXIT_FAILURE;
+        }
+        size_t count = 0;
+        for (int i = 3; i < argc; i++) {
+            if (strncmp(argv[i], "--readers=", 10) == 0) {
+                options.readers = strtoull(argv[i] + 10, NULL, 10);
+            } else if (strncmp(argv[i], "--depth=", 8) == 0) {
+                options.depth = strtoull(argv[i] + 8, NULL, 10);
+            } else {
+                inputs[count++] = argv[i];
+            }
+        }
+
+        struct batch_stats stats;
+        bool ok = batch_run(inputs, count, argv[2], &options, &stats);
+        free(inputs);
+        fprintf(stdout, "Mazes: %zu, failed: %zu\n", stats.mazes, stats.failures);
+        fprintf(stdout, "Busy: read %.2f ms, solve %.2f ms, write %.2f ms; wall %.2f ms\n",
+                stats.read_seconds * 1e3, stats.solve_seconds * 1e3, stats.write_seconds * 1e3, stats.wall_seconds * 1e3);
+        fprintf(stdout, "Stalls: readers %zu, solve %zu, writer queue %zu\n",
+                stats.read_stalls, stats.solve_stalls, stats.write_stalls);
+        if (!ok) {
+            return EXIT_FAILURE;
+        }
+
     } else {
         /* --- INVALID COMMAND --- */
-        fprintf(stderr, "Usage: ./maze check INPUT_FILE\n");
+        fprintf(stderr, "Usage: ./maze check INPUT_FILE [--threads=N]\n");
         fprintf(stderr, "       ./maze solve INPUT_FILE OUTPUT_FILE\n");
+        fprintf(stderr, "       ./maze path INPUT_FILE [OUTPUT_FILE]\n");
+        fprintf(stderr, "       ./maze multi INPUT_FILE [OUTPUT_FILE]\n");
+        fprintf(stderr, "       ./maze solve-ext INPUT_FILE [OUTPUT_FILE] [--mem=BYTES] [--tmp=DIR]\n");
+        fprintf(stderr, "       ./maze solve-compact INPUT_FILE [OUTPUT_FILE]\n");
+        fprintf(stderr, "       ./maze convert INPUT_FILE OUTPUT_FILE\n");
+        fprintf(stderr, "       ./maze batch OUTPUT_DIR INPUT_FILE... [--readers=N] [--depth=N]\n");
+        fprintf(stderr, "       ./maze bench [CELLS]\n");
+        fprintf(stderr, "       ./maze fuzz [ITERATIONS] [SEED] | fuzz-one FILE | fuzz-perf [CELLS]\n");
         return EXIT_FAILURE;
     }
 
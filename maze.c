@@ -1,10 +1,17 @@
 #include "maze.h"
 
+#include "ccl.h"
+#include "path.h"
 #include "queue.h"
+#include "validate.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+const int maze_dx[4] = { 0, 1, 0, -1 };
+const int maze_dy[4] = { -1, 0, 1, 0 };
 
 void add_spaces(struct maze *maze)
 {
@@ -23,10 +30,11 @@ void add_spaces(struct maze *maze)
             }
             // padding with spaces
             for (size_t x = 0; x < maze->line_lengths[y]; x++) {
-                new_line[x].value = maze->tiles[y][x].value;
+                new_line[x] = maze->tiles[y][x];
             }
             for (size_t x = line_length; x < maze->width; x++) {
                 new_line[x].value = ' ';
+                new_line[x].cost = MAZE_DEFAULT_COST;
             }
             free(maze->tiles[y]);
             maze->tiles[y] = new_line;
@@ -54,8 +62,35 @@ bool maze_is_within_bounds(struct maze *maze, struct position pos)
     assert(maze != NULL);
     int width = maze->width;
     int height = maze->height;
+    if (pos.y < 0 || pos.y > height - 1) {
+        return false;
+    }
     int line_length = maze->line_lengths[pos.y];
-    return pos.x >= 0 && pos.x <= width - 1 && pos.y >= 0 && pos.y <= height - 1 && pos.x < line_length;
+    return pos.x >= 0 && pos.x <= width - 1 && pos.x < line_length;
+}
+
+/*
+ * The walkability rule every solver shares: inside the maze, left of the row
+ * end count_Llength computed, and not a wall.
+ */
+bool maze_is_walkable(const struct maze *maze, struct position pos)
+{
+    assert(maze != NULL);
+    if (pos.x < 0 || pos.y < 0 || (size_t) pos.y >= maze->height) {
+        return false;
+    }
+    size_t x = (size_t) pos.x;
+    return x < maze->width && x < maze->line_lengths[pos.y] && maze->tiles[pos.y][x].value != '#';
+}
+
+// count_Llength on a raw text line: cells up to the last non-space inside width, at least one
+size_t maze_row_end(const char *line, size_t length, size_t width)
+{
+    size_t j = width - 1;
+    while (j > 0 && (j >= length || line[j] == ' ')) {
+        j--;
+    }
+    return j + 1;
 }
 
 bool bounds_overall(struct maze *maze, struct position pos)
@@ -110,12 +145,9 @@ void maze_get_adjacent_positions(struct position from, struct position adjacent_
 {
     // calculates coordinates for up, down, left, right
     assert(adjacent_positions != NULL);
-    int dx[4] = { 0, 1, 0, -1 };
-    int dy[4] = { -1, 0, 1, 0 };
-
     for (int i = 0; i < 4; i++) {
-        adjacent_positions[i].x = from.x + dx[i];
-        adjacent_positions[i].y = from.y + dy[i];
+        adjacent_positions[i].x = from.x + maze_dx[i];
+        adjacent_positions[i].y = from.y + maze_dy[i];
     }
 }
 
@@ -141,10 +173,10 @@ bool is_valid_entrance(struct maze *maze)
     if (maze_is_correct_col(maze, right) && maze->tiles[right.y][right.x].value == '#') {
         right_ = true;
     }
-    if (maze_is_correct_line(maze, up) && maze->tiles[up.y][up.x].value == '#') {
+    if (bounds_overall(maze, up) && maze->tiles[up.y][up.x].value == '#') {
         up_ = true;
     }
-    if (maze_is_correct_line(maze, down) && maze->tiles[down.y][down.x].value == '#') {
+    if (bounds_overall(maze, down) && maze->tiles[down.y][down.x].value == '#') {
         down_ = true;
     }
 
@@ -171,16 +203,33 @@ bool is_valid_exit(struct maze *maze)
     if (maze_is_correct_col(maze, right) && maze->tiles[right.y][right.x].value == '#') {
         right_ = true;
     }
-    if (maze_is_correct_line(maze, up) && maze->tiles[up.y][up.x].value == '#') {
+    if (bounds_overall(maze, up) && maze->tiles[up.y][up.x].value == '#') {
         up_ = true;
     }
-    if (maze_is_correct_line(maze, down) && maze->tiles[down.y][down.x].value == '#') {
+    if (bounds_overall(maze, down) && maze->tiles[down.y][down.x].value == '#') {
         down_ = true;
     }
 
     return (((left_ && right_) && (!down_ && !up_)) || ((down_ && up_) && (!left_ && !right_)));
 }
 
+bool is_valid_marker(struct maze *maze, struct position marker)
+{
+    // same door rule as entrance/exit: walls on exactly one opposite pair of sides
+    assert(maze != NULL);
+    struct position left = { marker.x - 1, marker.y };
+    struct position right = { marker.x + 1, marker.y };
+    struct position up = { marker.x, marker.y - 1 };
+    struct position down = { marker.x, marker.y + 1 };
+
+    bool left_ = maze_is_correct_col(maze, left) && maze->tiles[left.y][left.x].value == '#';
+    bool right_ = maze_is_correct_col(maze, right) && maze->tiles[right.y][right.x].value == '#';
+    bool up_ = bounds_overall(maze, up) && maze->tiles[up.y][up.x].value == '#';
+    bool down_ = bounds_overall(maze, down) && maze->tiles[down.y][down.x].value == '#';
+
+    return (((left_ && right_) && (!down_ && !up_)) || ((down_ && up_) && (!left_ && !right_)));
+}
+
 bool is_connected(struct maze *maze)
 {
     // alloc visited array
@@ -314,7 +363,7 @@ bool col_alone_wall(struct maze *maze)
     return true;
 }
 
-bool is_valid(struct maze *maze)
+static bool is_valid_rows(struct maze *maze)
 {
     // counts walls globally
     assert(maze != NULL);
@@ -374,10 +423,50 @@ bool is_valid(struct maze *maze)
             return false;
         }
     }
+    return true;
+}
 
-    // running all specific checks
+bool is_valid(struct maze *maze)
+{
+    assert(maze != NULL);
+
+    // pad short rows first, the scans below read every row up to width
     add_spaces(maze);
     count_Llength(maze);
+
+    // one striped pass does the row scan, column counts and component labels
+    struct validation validation;
+    if (maze->options.reference_checks) {
+        if (!is_valid_rows(maze)) {
+            return false;
+        }
+    } else {
+        // caught here so it is not reported as an allocation failure below
+        if (maze->width * maze->height > COMPONENTS_MAX_CELLS) {
+            fprintf(stderr, "maze too large\n");
+            return false;
+        }
+        maze->components = (struct components *) malloc(sizeof(struct components));
+        if (maze->components == NULL) {
+            fprintf(stderr, "memory allocation failed\n");
+            return false;
+        }
+        if (!validate_stripes(&validation, maze->components, maze, maze->options.threads)) {
+            fprintf(stderr, "memory allocation failed\n");
+            free(maze->components);
+            maze->components = NULL;
+            return false;
+        }
+        if (validation.bad_row < maze->height) {
+            if (!validation.isolated_wall) {
+                fprintf(stderr, "only one line#\n");
+            }
+            return false;
+        }
+        maze->num_walls = validation.num_walls;
+    }
+
+    // running all specific checks
     if (!is_valid_entrance(maze)) {
         fprintf(stderr,"invalid entrance\n");
         return false;
@@ -386,11 +475,31 @@ bool is_valid(struct maze *maze)
         fprintf(stderr,"invalid exit\n");
         return false;
     }
-    if (!is_connected(maze)) {
+    // extra doors are only present in multi-marker mode
+    for (size_t i = 2; i < maze->num_markers; i++) {
+        if (!is_valid_marker(maze, maze->markers[i])) {
+            fprintf(stderr,"invalid marker %zu\n", i);
+            return false;
+        }
+    }
+    if (maze->options.reference_checks) {
+        if (!is_connected(maze)) {
+            fprintf(stderr,"not connected\n");
+            return false;
+        }
+        if (!col_alone_wall(maze)) {
+            fprintf(stderr,"alone col\n");
+            return false;
+        }
+        return true;
+    }
+
+    // the labels answer wall connectivity here and reachability in solve
+    if (maze->components->num_wall_components > 1) {
         fprintf(stderr,"not connected\n");
         return false;
     };
-    if (!col_alone_wall(maze)) {
+    if (validation.alone_column) {
         fprintf(stderr,"alone col\n");
         return false;
     }
@@ -407,18 +516,52 @@ bool initialize_maze_buffers(struct maze *maze, size_t buffer_size)
     maze->line_lengths = (size_t *) malloc(buffer_size * sizeof(size_t));
     if (maze->line_lengths == NULL) {
         free(maze->tiles);
+        maze->tiles = NULL;
         return false;
     }
     return true;
 }
 
 bool maze_create(struct maze *maze, FILE *file)
+{
+    struct maze_options options = { .allow_many_markers = false, .threads = 1, .reference_checks = false };
+    return maze_create_with_options(maze, file, &options);
+}
+
+static bool maze_add_marker(struct maze *maze, size_t *capacity, struct position pos)
+{
+    // grows the marker table, doubling like the line buffer
+    if (maze->num_markers == *capacity) {
+        size_t new_capacity = *capacity == 0 ? 4 : *capacity * 2;
+        struct position *new_markers = (struct position *) realloc(maze->markers, new_capacity * sizeof(struct position));
+        if (new_markers == NULL) {
+            return false;
+        }
+        maze->markers = new_markers;
+        *capacity = new_capacity;
+    }
+    maze->markers[maze->num_markers++] = pos;
+    return true;
+}
+
+bool maze_create_with_options(struct maze *maze, FILE *file, const struct maze_options *options)
 {
     // buffer for reading lines
     assert(maze != NULL);
     assert(file != NULL);
+    assert(options != NULL);
+    // everything maze_destroy frees starts out empty, so any error path can leave it to maze_destroy
+    maze->tiles = NULL;
+    maze->line_lengths = NULL;
+    maze->height = 0;
+    maze->markers = NULL;
+    maze->num_markers = 0;
+    maze->components = NULL;
+    maze->options = *options;
+    size_t markers_capacity = 0;
     char *buffer = NULL;
     size_t buffer_size = 128;
+    size_t rows_capacity = 128;
     size_t line_length;
     size_t leftmost_wall = 0;
     size_t rightmost_wall = 0;
@@ -429,13 +572,14 @@ bool maze_create(struct maze *maze, FILE *file)
     }
 
     // alloc maze arrays
-     if (!initialize_maze_buffers(maze, buffer_size)) {
+     if (!initialize_maze_buffers(maze, rows_capacity)) {
         free(buffer);
         return false;
     }
 
     maze->width = 0;
     maze->height = 0;
+    maze->max_cost = MAZE_DEFAULT_COST;
     int entrance_count = 0;
 
     // reading file line by line
@@ -447,43 +591,63 @@ bool maze_create(struct maze *maze, FILE *file)
             buffer_size *= 2;
             char *buffer_new = (char *) realloc(buffer, buffer_size);
             if (buffer_new == NULL) {
+                // rows before y are owned by the maze, maze_destroy releases them
                 free(buffer);
-                free(maze->tiles);
-                free(maze->line_lengths);
+                maze->height = y;
                 return false;
             }
             buffer = buffer_new;
             if (fgets(buffer + line_length, buffer_size - line_length, file) == NULL) {
-                free(buffer);
-                free(maze->tiles);
-                free(maze->line_lengths);
-                return false;
+                break; // last line without a newline
             }
 
             line_length = strlen(buffer);
         }
 
+        // grow row tables, tall mazes exceed the initial capacity
+        if (y == rows_capacity) {
+            rows_capacity *= 2;
+            struct tile **tiles_new = (struct tile **) realloc(maze->tiles, rows_capacity * sizeof(struct tile *));
+            if (tiles_new == NULL) {
+                free(buffer);
+                maze->height = y;
+                return false;
+            }
+            maze->tiles = tiles_new;
+            size_t *lengths_new = (size_t *) realloc(maze->line_lengths, rows_capacity * sizeof(size_t));
+            if (lengths_new == NULL) {
+                free(buffer);
+                maze->height = y;
+                return false;
+            }
+            maze->line_lengths = lengths_new;
+        }
+
         // alloc row for tiles
         maze->tiles[y] = (struct tile *) malloc(line_length * sizeof(struct tile));
         if (maze->tiles[y] == NULL) {
-            for (size_t x = 0; x < y; x++){
-                free(maze->tiles[x]);
-            }
             free(buffer);
-            free(maze->tiles);
-            free(maze->line_lengths);
+            maze->height = y;
             return false;
         }
 
-        // validating allowed chars
+        // validating allowed chars, digits are walkable terrain with their own cost
         for (size_t x = 0; x < line_length; x++) {
-            if (buffer[x] != '#' && buffer[x] != 'X' && buffer[x] != ' ' && buffer[x] != '\n') {
+            bool terrain = buffer[x] >= '1' && buffer[x] <= '9';
+            if (buffer[x] != '#' && buffer[x] != 'X' && buffer[x] != ' ' && buffer[x] != '\n' && !terrain) {
+                // rows up to y are owned by the maze now, maze_destroy releases them
                 free(buffer);
-                free(maze->tiles);
-                free(maze->line_lengths);
+                maze->height = y + 1;
                 return false;
             }
             maze->tiles[y][x].value = buffer[x];
+            maze->tiles[y][x].cost = MAZE_DEFAULT_COST;
+            if (terrain) {
+                maze->tiles[y][x].cost = (unsigned char) (buffer[x] - '0');
+                if (maze->tiles[y][x].cost > maze->max_cost) {
+                    maze->max_cost = maze->tiles[y][x].cost;
+                }
+            }
 
             if (buffer[x] == '#') {
                 if (x < leftmost_wall) {
@@ -505,6 +669,12 @@ bool maze_create(struct maze *maze, FILE *file)
                     maze->exit.y = y;
                 }
                 entrance_count++;
+                if (entrance_count <= MAZE_MAX_MARKERS
+                        && !maze_add_marker(maze, &markers_capacity, (struct position){ x, y })) {
+                    free(buffer);
+                    maze->height = y + 1;
+                    return false;
+                }
             }
         }
         
@@ -519,7 +689,12 @@ bool maze_create(struct maze *maze, FILE *file)
     maze->width = rightmost_wall - leftmost_wall + 1;
     free(buffer);
     buffer = NULL;
-    if (entrance_count != 2) {
+    if (options->allow_many_markers) {
+        if (entrance_count < 2 || entrance_count > MAZE_MAX_MARKERS) {
+            fprintf(stderr, "invalid amount of markers");
+            return false;
+        }
+    } else if (entrance_count != 2) {
         fprintf(stderr, "invalid amount of entrances");
         return false;
     }
@@ -532,11 +707,149 @@ bool maze_create(struct maze *maze, FILE *file)
     return true;
 }
 
+/*
+ * Finds the shortest path from entrance to exit using BFS.
+ * Marks the path with 'o' characters in the maze structure.
+ * Returns true if a path is found, false otherwise.
+ */
+// original search, kept as the oracle for reference_checks mazes
+static bool solve_maze_reference(struct maze *maze)
+{
+    assert(maze != NULL);
+    struct queue queue_struct;
+    queue_init(&queue_struct);
+
+    // Arrays to keep track of visited nodes and path reconstruction, on the
+    // heap since large mazes overflow the stack
+    size_t cells = maze->height * maze->width;
+    bool *visited = (bool *) malloc(cells * sizeof(bool));
+    struct position *predecessors = (struct position *) malloc(cells * sizeof(struct position));
+    if (visited == NULL || predecessors == NULL) {
+        fprintf(stderr, "memory allocation failed\n");
+        free(visited);
+        free(predecessors);
+        return false;
+    }
+
+    // Mark entrance as part of the path initially
+    maze->tiles[maze->entrance.y][maze->entrance.x].value = 'o';
+
+    // Initialize visited array and predecessors
+    for (size_t i = 0; i < cells; i++) {
+        visited[i] = false;
+        predecessors[i].x = -1;
+        predecessors[i].y = -1;
+    }
+
+    visited[(size_t) maze->entrance.y * maze->width + maze->entrance.x] = true;
+    queue_insert(&queue_struct, (struct node){ .pos = maze->entrance, .parent = NULL });
+
+    while (!queue_is_empty(&queue_struct)) {
+        struct node current = queue_pop(&queue_struct);
+
+        // Check if we reached the exit
+        if (current.pos.x == maze->exit.x && current.pos.y == maze->exit.y) {
+            struct position pos = current.pos;
+            
+            // Backtrack from exit to entrance to mark the path
+            while (pos.x != maze->entrance.x || pos.y != maze->entrance.y) {
+                maze->tiles[pos.y][pos.x].value = 'o';
+                pos = predecessors[(size_t) pos.y * maze->width + pos.x];
+            }
+            queue_free(&queue_struct);
+            free(visited);
+            free(predecessors);
+            return true;
+        }
+
+        // Explore neighbors
+        for (int i = 0; i < 4; i++) {
+            struct position next = { current.pos.x + maze_dx[i], current.pos.y + maze_dy[i] };
+            
+            if (maze_is_walkable(maze, next) && !visited[(size_t) next.y * maze->width + next.x]) {
+                
+                visited[(size_t) next.y * maze->width + next.x] = true;
+                predecessors[(size_t) next.y * maze->width + next.x] = current.pos;
+                queue_insert(&queue_struct, (struct node){ .pos = next, .parent = &current });
+            }
+        }
+    }
+    
+    queue_free(&queue_struct);
+    free(visited);
+    free(predecessors);
+    return false;
+}
+
+bool solve_maze(struct maze *maze)
+{
+    // marks the shortest path with 'o', found by the specialized kernels unless reference_checks is set
+    assert(maze != NULL);
+    if (maze->options.reference_checks) {
+        return solve_maze_reference(maze);
+    }
+
+    // like the reference, the entrance is marked even when no path exists
+    maze->tiles[maze->entrance.y][maze->entrance.x].value = 'o';
+    struct maze_path path;
+    if (!maze_solve_path(maze, &path)) {
+        return false;
+    }
+    struct position pos = path.start;
+    struct position adjacent_positions[4];
+    for (size_t i = 0; i < path.length; i++) {
+        // adjacent positions come in Up, Right, Down, Left order like enum path_move
+        maze_get_adjacent_positions(pos, adjacent_positions);
+        pos = adjacent_positions[maze_path_move(&path, i)];
+        maze->tiles[pos.y][pos.x].value = 'o';
+    }
+    maze_path_destroy(&path);
+    return true;
+}
+
+/*
+ * Prints the solved maze to the specified output file.
+ * Handles trimming of leading empty columns to match the assignment format.
+ */
+void maze_print(struct maze *maze, FILE *output_file)
+{
+    assert(maze != NULL);
+    assert(output_file != NULL);
+    
+    // Find the leftmost column that contains actual maze content (not just spaces)
+    size_t leftmost_non_space_col = maze->width;
+
+    for (size_t i = 0; i < maze->height; i++) {
+        for (size_t j = 0; j < maze->width; j++) {
+            if (maze->tiles[i][j].value != ' ') {
+                if (j < leftmost_non_space_col) {
+                    leftmost_non_space_col = j;
+                }
+                break;
+            }
+        }
+    }
+    
+    // Update line lengths to ensure correct trimming from the right
+    count_Llength(maze);
+
+    for (size_t i = 0; i < maze->height; i++) {
+        // Start printing from the first useful column
+        for (size_t j = leftmost_non_space_col; j < maze->line_lengths[i]; j++) {
+            if (maze->tiles[i][j].value == '\n') {
+                continue;
+            }
+            fprintf(output_file, "%c", maze->tiles[i][j].value);
+        }
+        fprintf(output_file, "\n");
+    }
+}
+
 void maze_destroy(struct maze *maze)
 {
     assert(maze != NULL);
     if (maze->tiles != NULL) {
-        for (size_t y = 0; y <= maze->height - 1; y++) {
+        for (size_t y = 0; y < maze->height; y++) {
             free(maze->tiles[y]);
         }
     }
@@ -544,6 +857,11 @@ void maze_destroy(struct maze *maze)
     // free all allocated memory
     free(maze->tiles);
     free(maze->line_lengths);
+    free(maze->markers);
+    if (maze->components != NULL) {
+        components_destroy(maze->components);
+        free(maze->components);
+    }
     maze->width = 0;
     maze->height = 0;
     maze->entrance.x = 0;
@@ -552,7 +870,25 @@ void maze_destroy(struct maze *maze)
     maze->exit.y = 0;
     maze->num_walls = 0;
     maze->tiles = NULL;
+    maze->markers = NULL;
+    maze->num_markers = 0;
+    maze->components = NULL;
     maze = NULL;
 }
 
+// monotonic wall clock for the timing reports
+double maze_now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
+// xorshift64*, deterministic across platforms unlike rand()
+uint64_t maze_next_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
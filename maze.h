@@ -8,9 +8,13 @@
 #include <stdint.h>
 #include <stdio.h>
 
+// traversal cost of ' ' and 'X'; terrain digits '1'-'9' carry their own value
+#define MAZE_DEFAULT_COST 1
+
 struct tile
 {
     char value;
+    unsigned char cost; // cost of stepping onto the tile
 };
 
 struct position
@@ -18,6 +22,18 @@ struct position
     int x, y;
 };
 
+// upper bound on 'X' markers accepted in multi-marker mode (one bit per marker)
+#define MAZE_MAX_MARKERS 64
+
+struct maze_options
+{
+    bool allow_many_markers; // accept 2..MAZE_MAX_MARKERS markers instead of exactly two
+    size_t threads;          // row stripes labeled in parallel during validation, 0 or 1 runs inline
+    bool reference_checks;   // validate with the original is_connected BFS, for differential testing
+};
+
+struct components;
+
 struct maze
 {
     size_t width;
@@ -28,10 +44,22 @@ struct maze
     struct tile **tiles;
     size_t *line_lengths;
     size_t num_outer_walls;
+    struct position *markers; // every 'X' in reading order, markers[0] == entrance, markers[1] == exit
+    size_t num_markers;
+    unsigned char max_cost; // highest terrain cost, MAZE_DEFAULT_COST when the maze has no digits
+    struct components *components; // wall and open component labels, filled by is_valid
+    struct maze_options options;   // options the maze was loaded with
 };
+// offsets for moving Up, Right, Down, Left, the neighbour order of every search
+extern const int maze_dx[4];
+extern const int maze_dy[4];
+
 bool maze_create(struct maze *maze, FILE *file);
+bool maze_create_with_options(struct maze *maze, FILE *file, const struct maze_options *options);
 void maze_destroy(struct maze *maze);
 bool maze_is_within_bounds(struct maze *maze, struct position pos);
+bool maze_is_walkable(const struct maze *maze, struct position pos);
+size_t maze_row_end(const char *line, size_t length, size_t width);
 bool maze_get_tile(struct maze *maze, struct position pos, struct tile *tile);
 bool maze_set_tile(struct maze *maze, struct position pos, struct tile tile);
 void maze_get_adjacent_positions(struct position from, struct position adjacent_positions[4]);
@@ -42,4 +70,10 @@ void count_Llength(struct maze *maze);
 bool is_valid(struct maze *maze);
 bool bounds_overall(struct maze *maze, struct position pos);
 bool is_connected(struct maze *maze);
+bool is_valid_marker(struct maze *maze, struct position marker);
+bool col_alone_wall(struct maze *maze);
+bool solve_maze(struct maze *maze);
+void maze_print(struct maze *maze, FILE *output_file);
+double maze_now_seconds(void);
+uint64_t maze_next_random(uint64_t *state);
 #endif // MAZE_H
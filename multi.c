@@ -0,0 +1,259 @@
+#include "multi.h"
+
+#include "path.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Multi-marker solver.
+ * Runs one BFS seeded from every 'X' at once. Every cell keeps a bitmask of
+ * the marker labels that already reached it, and each frontier entry holds a
+ * cell with the bitmask of labels that arrived there in that round: a cell is
+ * queued once per round that brings it a new label and passes all of them on
+ * together. A label stops spreading once it has reached every other marker.
+ * The distance from each marker to all others is found in a single pass
+ * instead of one solve_maze run per pair.
+ */
+
+struct frontier_entry
+{
+    size_t cell;
+    uint64_t labels;
+};
+
+struct frontier
+{
+    struct frontier_entry *entries;
+    size_t count;
+    size_t capacity;
+};
+
+static bool frontier_push(struct frontier *f, size_t cell, uint64_t labels)
+{
+    if (f->count == f->capacity) {
+        size_t new_capacity = f->capacity == 0 ? 64 : f->capacity * 2;
+        struct frontier_entry *new_entries = (struct frontier_entry *) realloc(f->entries, new_capacity * sizeof(struct frontier_entry));
+        if (new_entries == NULL) {
+            return false;
+        }
+        f->entries = new_entries;
+        f->capacity = new_capacity;
+    }
+    f->entries[f->count].cell = cell;
+    f->entries[f->count].labels = labels;
+    f->count++;
+    return true;
+}
+
+// markers are stored in reading order, so their cell numbers are sorted
+static size_t marker_index(struct maze *maze, size_t cell)
+{
+    size_t low = 0;
+    size_t high = maze->num_markers;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        size_t mid_cell = (size_t) maze->markers[mid].y * maze->width + maze->markers[mid].x;
+        if (mid_cell < cell) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// draws a shortest route between markers 'from' and 'to' with 'o'
+static bool mark_path(struct maze *maze, size_t from, size_t to)
+{
+    struct maze_path path;
+    if (!maze_find_path(maze, maze->markers[from], maze->markers[to], &path)) {
+        return false;
+    }
+    struct position pos = path.start;
+    maze->tiles[pos.y][pos.x].value = 'o';
+    for (size_t i = 0; i < path.length; i++) {
+        enum path_move move = maze_path_move(&path, i);
+        pos.x += maze_dx[move];
+        pos.y += maze_dy[move];
+        maze->tiles[pos.y][pos.x].value = 'o';
+    }
+    maze_path_destroy(&path);
+    return true;
+}
+
+/*
+ * Fills result with the all-pairs distance matrix between markers and the
+ * nearest other marker of each one. When mark_paths is set, the route from
+ * every marker to its nearest neighbour is drawn with 'o' into the maze; the
+ * labelled BFS keeps no predecessors, so each drawn route is searched again
+ * on its own. Returns false on allocation failure.
+ */
+bool multi_solve(struct maze *maze, struct multi_result *result, bool mark_paths)
+{
+    assert(maze != NULL);
+    assert(result != NULL);
+    assert(maze->num_markers <= MAZE_MAX_MARKERS);
+
+    size_t n = maze->num_markers;
+    size_t cells = maze->height * maze->width;
+    result->num_markers = n;
+    result->distances = (size_t *) malloc(n * n * sizeof(size_t));
+    result->nearest = (size_t *) malloc(n * sizeof(size_t));
+    uint64_t *seen = (uint64_t *) malloc(cells * sizeof(uint64_t));
+    uint64_t *arrived = (uint64_t *) calloc(cells, sizeof(uint64_t));
+    struct frontier current = { NULL, 0, 0 };
+    struct frontier next = { NULL, 0, 0 };
+    bool ok = result->distances != NULL && result->nearest != NULL && seen != NULL && arrived != NULL;
+
+    // walls count as reached by every label, so the search only needs the bounds check
+    for (size_t cell = 0; ok && cell < cells; cell++) {
+        struct position pos = { (int) (cell % maze->width), (int) (cell / maze->width) };
+        seen[cell] = maze_is_walkable(maze, pos) ? 0 : ~(uint64_t) 0;
+    }
+
+    // labels that still miss some marker, finished ones stop spreading
+    uint64_t active = 0;
+    size_t missing[MAZE_MAX_MARKERS];
+    for (size_t i = 0; ok && i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            result->distances[i * n + j] = i == j ? 0 : MULTI_UNREACHABLE;
+        }
+        size_t cell = (size_t) maze->markers[i].y * maze->width + maze->markers[i].x;
+        seen[cell] = (uint64_t) 1 << i;
+        missing[i] = n - 1;
+        active |= n > 1 ? (uint64_t) 1 << i : 0;
+        ok = frontier_push(&current, cell, (uint64_t) 1 << i);
+    }
+
+    // level-synchronous BFS, every label advances one step per round
+    for (size_t level = 1; ok && current.count > 0 && active != 0; level++) {
+        next.count = 0;
+        for (size_t e = 0; ok && e < current.count; e++) {
+            size_t cell = current.entries[e].cell;
+            uint64_t labels = current.entries[e].labels & active;
+            if (labels == 0) {
+                continue;
+            }
+            struct position pos = { (int) (cell % maze->width), (int) (cell / maze->width) };
+
+            for (int d = 0; d < 4; d++) {
+                struct position adj = { pos.x + maze_dx[d], pos.y + maze_dy[d] };
+                if (adj.x < 0 || adj.y < 0 || (size_t) adj.x >= maze->width || (size_t) adj.y >= maze->height) {
+                    continue;
+                }
+                size_t adj_cell = (size_t) adj.y * maze->width + adj.x;
+                uint64_t fresh = labels & ~seen[adj_cell];
+                if (fresh == 0) {
+                    continue;
+                }
+                seen[adj_cell] |= fresh;
+                if (arrived[adj_cell] == 0 && !frontier_push(&next, adj_cell, 0)) {
+                    ok = false;
+                    break;
+                }
+                arrived[adj_cell] |= fresh;
+                if (maze->tiles[adj.y][adj.x].value == 'X') {
+                    size_t m = marker_index(maze, adj_cell);
+                    // each label reaches a cell once, so none of these pairs is set yet
+                    for (; fresh != 0; fresh &= fresh - 1) {
+                        size_t label = (size_t) __builtin_ctzll(fresh);
+                        result->distances[label * n + m] = level;
+                        if (--missing[label] == 0) {
+                            active &= ~((uint64_t) 1 << label);
+                        }
+                    }
+                }
+            }
+        }
+        for (size_t e = 0; e < next.count; e++) {
+            next.entries[e].labels = arrived[next.entries[e].cell];
+            arrived[next.entries[e].cell] = 0;
+        }
+        struct frontier tmp = current;
+        current = next;
+        next = tmp;
+    }
+
+    free(current.entries);
+    free(next.entries);
+    free(seen);
+    free(arrived);
+    if (!ok) {
+        multi_result_destroy(result);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        result->nearest[i] = n;
+        for (size_t j = 0; j < n; j++) {
+            size_t d = result->distances[i * n + j];
+            if (j != i && d != MULTI_UNREACHABLE
+                    && (result->nearest[i] == n || d < result->distances[i * n + result->nearest[i]])) {
+                result->nearest[i] = j;
+            }
+        }
+    }
+
+    for (size_t i = 0; mark_paths && i < n; i++) {
+        size_t j = result->nearest[i];
+        // a pair of mutual nearest neighbours shares one route
+        if (j < n && !(result->nearest[j] == i && j < i) && !mark_path(maze, i, j)) {
+            multi_result_destroy(result);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prints marker positions, the distance matrix and nearest neighbours ('-' means unreachable)
+void multi_result_print(struct maze *maze, struct multi_result *result, FILE *output_file)
+{
+    assert(maze != NULL);
+    assert(result != NULL);
+    assert(output_file != NULL);
+    size_t n = result->num_markers;
+
+    fprintf(output_file, "Markers: %zu\n", n);
+    for (size_t i = 0; i < n; i++) {
+        fprintf(output_file, "%4zu: (%d, %d)\n", i, maze->markers[i].x, maze->markers[i].y);
+    }
+
+    fprintf(output_file, "Distances:\n    ");
+    for (size_t j = 0; j < n; j++) {
+        fprintf(output_file, " %6zu", j);
+    }
+    fprintf(output_file, "\n");
+    for (size_t i = 0; i < n; i++) {
+        fprintf(output_file, "%4zu", i);
+        for (size_t j = 0; j < n; j++) {
+            if (result->distances[i * n + j] == MULTI_UNREACHABLE) {
+                fprintf(output_file, " %6s", "-");
+            } else {
+                fprintf(output_file, " %6zu", result->distances[i * n + j]);
+            }
+        }
+        fprintf(output_file, "\n");
+    }
+
+    fprintf(output_file, "Nearest:\n");
+    for (size_t i = 0; i < n; i++) {
+        if (result->nearest[i] == n) {
+            fprintf(output_file, "%4zu -> -\n", i);
+        } else {
+            fprintf(output_file, "%4zu -> %zu (%zu)\n", i, result->nearest[i], result->distances[i * n + result->nearest[i]]);
+        }
+    }
+}
+
+void multi_result_destroy(struct multi_result *result)
+{
+    assert(result != NULL);
+    free(result->distances);
+    free(result->nearest);
+    result->distances = NULL;
+    result->nearest = NULL;
+    result->num_markers = 0;
+}
@@ -0,0 +1,23 @@
+#ifndef MULTI_H
+#define MULTI_H
+
+#include "maze.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// distance reported for marker pairs that are not connected
+#define MULTI_UNREACHABLE ((size_t) -1)
+
+struct multi_result
+{
+    size_t num_markers;
+    size_t *distances; // num_markers x num_markers, row i holds path lengths from marker i
+    size_t *nearest;   // nearest other marker for each marker, num_markers if none is reachable
+};
+
+bool multi_solve(struct maze *maze, struct multi_result *result, bool mark_paths);
+void multi_result_print(struct maze *maze, struct multi_result *result, FILE *output_file);
+void multi_result_destroy(struct multi_result *result);
+
+#endif // MULTI_H
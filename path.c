@@ -0,0 +1,162 @@
+#include "path.h"
+
+#include "kernel.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/*
+ * Path queries.
+ * A search never writes to the maze, so one loaded maze can answer many
+ * queries, also from several threads at once. The route comes back as two
+ * bits per move plus a checkpoint every PATH_CHECKPOINT_INTERVAL moves, so
+ * any position along it is found by replaying a bounded number of moves.
+ * Drawing the route with 'o' only happens on a temporary copy when printing.
+ */
+
+static struct position apply_move(struct position pos, enum path_move move)
+{
+    pos.x += maze_dx[move];
+    pos.y += maze_dy[move];
+    return pos;
+}
+
+/*
+ * Finds the shortest route from 'from' to 'to' using the walkability rule of
+ * solve_maze. Terrain costs are ignored, every step counts as one. Returns
+ * false if there is no route or memory runs out; path only needs
+ * maze_path_destroy after a successful call.
+ */
+bool maze_find_path(const struct maze *maze, struct position from, struct position to, struct maze_path *path)
+{
+    assert(maze != NULL);
+    assert(path != NULL);
+    if (!kernel_find_path(maze, from, to, KERNEL_AUTO_INDEX, path)) {
+        return false;
+    }
+    return maze_path_add_checkpoints(path);
+}
+
+/*
+ * Fills the checkpoints of a path whose start, length and moves are set.
+ * Returns false and frees the moves if memory runs out.
+ */
+bool maze_path_add_checkpoints(struct maze_path *path)
+{
+    assert(path != NULL);
+    path->num_checkpoints = path->length / PATH_CHECKPOINT_INTERVAL + 1;
+    path->checkpoints = (struct position *) malloc(path->num_checkpoints * sizeof(struct position));
+    if (path->checkpoints == NULL) {
+        fprintf(stderr, "memory allocation failed\n");
+        free(path->moves);
+        path->moves = NULL;
+        return false;
+    }
+    struct position pos = path->start;
+    path->checkpoints[0] = pos;
+    for (size_t i = 0; i < path->length; i++) {
+        pos = apply_move(pos, maze_path_move(path, i));
+        if ((i + 1) % PATH_CHECKPOINT_INTERVAL == 0) {
+            path->checkpoints[(i + 1) / PATH_CHECKPOINT_INTERVAL] = pos;
+        }
+    }
+    return true;
+}
+
+// route from the entrance to the exit
+bool maze_solve_path(const struct maze *maze, struct maze_path *path)
+{
+    assert(maze != NULL);
+    return maze_find_path(maze, maze->entrance, maze->exit, path);
+}
+
+void maze_path_destroy(struct maze_path *path)
+{
+    assert(path != NULL);
+    free(path->moves);
+    free(path->checkpoints);
+    path->moves = NULL;
+    path->checkpoints = NULL;
+    path->length = 0;
+    path->num_checkpoints = 0;
+}
+
+enum path_move maze_path_move(const struct maze_path *path, size_t i)
+{
+    assert(path != NULL);
+    assert(i < path->length);
+    return (enum path_move) ((path->moves[i / 4] >> (2 * (i % 4))) & 3);
+}
+
+// position after i moves, 0 <= i <= length
+struct position maze_path_position(const struct maze_path *path, size_t i)
+{
+    assert(path != NULL);
+    assert(i <= path->length);
+    size_t k = i / PATH_CHECKPOINT_INTERVAL;
+    struct position pos = path->checkpoints[k];
+    for (size_t j = k * PATH_CHECKPOINT_INTERVAL; j < i; j++) {
+        pos = apply_move(pos, maze_path_move(path, j));
+    }
+    return pos;
+}
+
+/*
+ * Prints the maze like maze_print after solve_maze, with the route drawn
+ * with 'o' on a copy of the tiles. The maze stays untouched. Returns false
+ * if the copy cannot be allocated.
+ */
+bool maze_path_print(const struct maze *maze, const struct maze_path *path, FILE *output_file)
+{
+    assert(maze != NULL);
+    assert(path != NULL);
+    assert(output_file != NULL);
+
+    struct maze copy = *maze;
+    copy.components = NULL;
+    copy.tiles = (struct tile **) calloc(maze->height, sizeof(struct tile *));
+    copy.line_lengths = (size_t *) malloc(maze->height * sizeof(size_t));
+    bool ok = copy.tiles != NULL && copy.line_lengths != NULL;
+    for (size_t y = 0; ok && y < maze->height; y++) {
+        // maze_print reads at most width tiles of a row
+        copy.tiles[y] = (struct tile *) malloc(maze->width * sizeof(struct tile));
+        ok = copy.tiles[y] != NULL;
+        for (size_t x = 0; ok && x < maze->width; x++) {
+            copy.tiles[y][x] = maze->tiles[y][x];
+        }
+        if (ok) {
+            copy.line_lengths[y] = maze->line_lengths[y];
+        }
+    }
+
+    if (ok) {
+        struct position pos = path->start;
+        copy.tiles[pos.y][pos.x].value = 'o';
+        for (size_t i = 0; i < path->length; i++) {
+            pos = apply_move(pos, maze_path_move(path, i));
+            copy.tiles[pos.y][pos.x].value = 'o';
+        }
+        maze_print(&copy, output_file);
+    } else {
+        fprintf(stderr, "memory allocation failed\n");
+    }
+
+    for (size_t y = 0; copy.tiles != NULL && y < maze->height; y++) {
+        free(copy.tiles[y]);
+    }
+    free(copy.tiles);
+    free(copy.line_lengths);
+    return ok;
+}
+
+// one letter per move (U, R, D, L) followed by a newline
+void maze_path_print_moves(const struct maze_path *path, FILE *output_file)
+{
+    assert(path != NULL);
+    assert(output_file != NULL);
+    static const char letters[4] = { 'U', 'R', 'D', 'L' };
+    for (size_t i = 0; i < path->length; i++) {
+        fputc(letters[maze_path_move(path, i)], output_file);
+    }
+    fputc('\n', output_file);
+}
@@ -0,0 +1,46 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "maze.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// moves between two stored positions, maze_path_position replays at most this many
+#define PATH_CHECKPOINT_INTERVAL 1024
+
+enum path_move
+{
+    PATH_UP,
+    PATH_RIGHT,
+    PATH_DOWN,
+    PATH_LEFT,
+};
+
+/*
+ * A route through a maze that leaves the maze itself untouched. Move i is
+ * stored in bits 2 * (i % 4) of moves[i / 4]; checkpoints[k] is the position
+ * after k * PATH_CHECKPOINT_INTERVAL moves, checkpoints[0] being start.
+ */
+struct maze_path
+{
+    struct position start;
+    struct position end;
+    size_t length; // number of moves
+    uint8_t *moves;
+    struct position *checkpoints;
+    size_t num_checkpoints;
+};
+
+bool maze_find_path(const struct maze *maze, struct position from, struct position to, struct maze_path *path);
+bool maze_solve_path(const struct maze *maze, struct maze_path *path);
+bool maze_path_add_checkpoints(struct maze_path *path);
+void maze_path_destroy(struct maze_path *path);
+enum path_move maze_path_move(const struct maze_path *path, size_t i);
+struct position maze_path_position(const struct maze_path *path, size_t i);
+bool maze_path_print(const struct maze *maze, const struct maze_path *path, FILE *output_file);
+void maze_path_print_moves(const struct maze_path *path, FILE *output_file);
+
+#endif // PATH_H
@@ -0,0 +1,62 @@
+#include "solve.h"
+
+#include "ccl.h"
+#include "dial.h"
+
+#include <assert.h>
+
+/*
+ * The load, validate and solve steps shared by the solve and batch modes.
+ * Nothing needs destroying unless SOLVE_OK is returned.
+ */
+enum solve_status solution_create(struct solution *solution, FILE *input_file)
+{
+    assert(solution != NULL);
+    assert(input_file != NULL);
+
+    solution->have_path = false;
+    if (!maze_create(&solution->maze, input_file)) {
+        maze_destroy(&solution->maze);
+        return SOLVE_INVALID;
+    }
+
+    // plain BFS stays the fast path, Dial's buckets only when terrain has real costs
+    struct maze *maze = &solution->maze;
+    bool solved;
+    if (!components_connected(maze->components)) {
+        solved = false; // different open components, no search needed
+    } else if (maze->max_cost == MAZE_DEFAULT_COST) {
+        solved = solution->have_path = maze_solve_path(maze, &solution->path);
+        solution->cost = solved ? solution->path.length : 0;
+    } else {
+        solved = solve_maze_weighted(maze, &solution->cost);
+    }
+    if (!solved) {
+        maze_destroy(maze);
+        return SOLVE_NO_SOLUTION;
+    }
+    return SOLVE_OK;
+}
+
+// prints like maze_print after solve_maze, false if the path copy cannot be allocated
+bool solution_print(struct solution *solution, FILE *output_file)
+{
+    assert(solution != NULL);
+    assert(output_file != NULL);
+
+    if (solution->have_path) {
+        return maze_path_print(&solution->maze, &solution->path, output_file);
+    }
+    maze_print(&solution->maze, output_file);
+    return true;
+}
+
+void solution_destroy(struct solution *solution)
+{
+    assert(solution != NULL);
+    if (solution->have_path) {
+        maze_path_destroy(&solution->path);
+        solution->have_path = false;
+    }
+    maze_destroy(&solution->maze);
+}
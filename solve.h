@@ -0,0 +1,33 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include "maze.h"
+#include "path.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+enum solve_status
+{
+    SOLVE_OK,
+    SOLVE_INVALID,
+    SOLVE_NO_SOLUTION,
+};
+
+/*
+ * A loaded and solved maze. Unweighted mazes keep the BFS route as a move
+ * list and leave the tiles alone, weighted ones are marked by Dial's solver.
+ */
+struct solution
+{
+    struct maze maze;
+    struct maze_path path;
+    bool have_path;
+    size_t cost; // summed terrain costs of the route, its length on mazes without terrain
+};
+
+enum solve_status solution_create(struct solution *solution, FILE *input_file);
+bool solution_print(struct solution *solution, FILE *output_file);
+void solution_destroy(struct solution *solution);
+
+#endif // SOLVE_H
@@ -0,0 +1,104 @@
+#include "spsc.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Lock-free SPSC queue.
+ * head and tail only grow; the ring is full when they are capacity apart.
+ * The producer publishes a slot with a release store of tail and the consumer
+ * frees it with a release store of head, each side reading the other counter
+ * with an acquire load. Blocking push/pop spin with sched_yield and then
+ * back off to short sleeps, so a stalled stage does not burn a whole core.
+ */
+
+#define SPSC_SPIN_LIMIT 64
+#define SPSC_SLEEP_NS 50000
+
+static void backoff(unsigned *spins)
+{
+    if (*spins < SPSC_SPIN_LIMIT) {
+        (*spins)++;
+        sched_yield();
+    } else {
+        struct timespec pause = { 0, SPSC_SLEEP_NS };
+        nanosleep(&pause, NULL);
+    }
+}
+
+bool spsc_init(struct spsc_queue *queue, size_t capacity)
+{
+    assert(queue != NULL);
+    assert(capacity > 0);
+    queue->slots = (void **) malloc(capacity * sizeof(void *));
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->empty_waits = 0;
+    queue->full_waits = 0;
+    return queue->slots != NULL;
+}
+
+void spsc_destroy(struct spsc_queue *queue)
+{
+    assert(queue != NULL);
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+// producer side, false when the queue is full
+bool spsc_try_push(struct spsc_queue *queue, void *item)
+{
+    size_t tail = queue->tail;
+    size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail - head == queue->capacity) {
+        return false;
+    }
+    queue->slots[tail % queue->capacity] = item;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// consumer side, false when the queue is empty
+bool spsc_try_pop(struct spsc_queue *queue, void **item)
+{
+    size_t head = queue->head;
+    size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    *item = queue->slots[head % queue->capacity];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// waits while the queue is full, this is the backpressure on the producer
+void spsc_push(struct spsc_queue *queue, void *item)
+{
+    assert(queue != NULL);
+    unsigned spins = 0;
+    if (spsc_try_push(queue, item)) {
+        return;
+    }
+    queue->full_waits++;
+    while (!spsc_try_push(queue, item)) {
+        backoff(&spins);
+    }
+}
+
+void *spsc_pop(struct spsc_queue *queue)
+{
+    assert(queue != NULL);
+    unsigned spins = 0;
+    void *item;
+    if (spsc_try_pop(queue, &item)) {
+        return item;
+    }
+    queue->empty_waits++;
+    while (!spsc_try_pop(queue, &item)) {
+        backoff(&spins);
+    }
+    return item;
+}
@@ -0,0 +1,35 @@
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// keeps the producer and consumer counters on separate cache lines
+#define SPSC_CACHE_LINE 64
+
+/*
+ * Bounded single-producer single-consumer ring of pointers. head is only
+ * written by the consumer and tail only by the producer, so the queue needs
+ * no lock, just acquire/release ordering on the two counters.
+ */
+struct spsc_queue
+{
+    void **slots;
+    size_t capacity;
+    char pad0[SPSC_CACHE_LINE];
+    size_t head;       // next slot to pop
+    size_t empty_waits; // consumer found the queue empty
+    char pad1[SPSC_CACHE_LINE];
+    size_t tail;       // next slot to push
+    size_t full_waits; // producer was held back by a full queue
+    char pad2[SPSC_CACHE_LINE];
+};
+
+bool spsc_init(struct spsc_queue *queue, size_t capacity);
+void spsc_destroy(struct spsc_queue *queue);
+bool spsc_try_push(struct spsc_queue *queue, void *item);
+bool spsc_try_pop(struct spsc_queue *queue, void **item);
+void spsc_push(struct spsc_queue *queue, void *item);
+void *spsc_pop(struct spsc_queue *queue);
+
+#endif // SPSC_H
@@ -0,0 +1,50 @@
+#include "stripes.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/*
+ * Row-stripe worker pool shared by the labeling and validation passes.
+ * Jobs are plain structs laid out 'job_size' bytes apart; fn gets a pointer
+ * to one of them.
+ */
+
+/*
+ * Runs fn on every job, the first one on the calling thread. Jobs whose
+ * thread cannot be started run inline, so the result never depends on how
+ * many threads were actually available.
+ */
+void stripes_run(void *jobs, size_t job_size, size_t count, void *(*fn)(void *))
+{
+    char *base = (char *) jobs;
+    pthread_t *workers = count > 1 ? (pthread_t *) malloc(count * sizeof(pthread_t)) : NULL;
+    size_t started = 1;
+    for (size_t i = 1; workers != NULL && i < count; i++) {
+        if (pthread_create(&workers[i], NULL, fn, base + i * job_size) != 0) {
+            break;
+        }
+        started++;
+    }
+    for (size_t i = started; i < count; i++) {
+        fn(base + i * job_size);
+    }
+    if (count > 0) {
+        fn(base);
+    }
+    for (size_t i = 1; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+}
+
+// stripes to use for 'threads' workers, at least one row each
+size_t stripes_count(size_t threads, size_t rows)
+{
+    if (threads == 0) {
+        threads = 1;
+    }
+    if (threads > rows) {
+        threads = rows > 0 ? rows : 1;
+    }
+    return threads;
+}
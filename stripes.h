@@ -0,0 +1,15 @@
+#ifndef STRIPES_H
+#define STRIPES_H
+
+#include <stddef.h>
+
+void stripes_run(void *jobs, size_t job_size, size_t count, void *(*fn)(void *));
+size_t stripes_count(size_t threads, size_t rows);
+
+// first row of stripe i when 'rows' rows are split into 'count' stripes
+static inline size_t stripe_begin(size_t rows, size_t i, size_t count)
+{
+    return rows * i / count;
+}
+
+#endif // STRIPES_H
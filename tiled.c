@@ -0,0 +1,101 @@
+#include "tiled.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+/*
+ * Blocked grid layout, an experiment for the benchmark.
+ * Tiles are grouped into (1 << block_w_shift) x (1 << block_h_shift) blocks
+ * that are contiguous in memory, so column scans stay inside one small
+ * block instead of striding over whole rows. The grid is a
+ * separate copy of the maze, the maze itself keeps its row arrays; only the
+ * column check is timed on it against col_alone_wall on the rows.
+ */
+
+static size_t blocks_needed(size_t length, unsigned shift)
+{
+    return (length + ((size_t) 1 << shift) - 1) >> shift;
+}
+
+bool tiled_grid_create(struct tiled_grid *grid, struct maze *maze, unsigned block_w_shift, unsigned block_h_shift)
+{
+    assert(grid != NULL);
+    assert(maze != NULL);
+
+    grid->width = maze->width;
+    grid->height = maze->height;
+    grid->block_w_shift = block_w_shift;
+    grid->block_h_shift = block_h_shift;
+    grid->blocks_x = blocks_needed(maze->width, block_w_shift);
+    grid->blocks_y = blocks_needed(maze->height, block_h_shift);
+
+    size_t cells = (grid->blocks_x * grid->blocks_y) << (block_w_shift + block_h_shift);
+    grid->cells = (struct tile *) malloc(cells * sizeof(struct tile));
+    if (grid->cells == NULL) {
+        tiled_grid_destroy(grid);
+        return false;
+    }
+
+    // padding of partial edge blocks reads as walls
+    for (size_t i = 0; i < cells; i++) {
+        grid->cells[i].value = '#';
+        grid->cells[i].cost = MAZE_DEFAULT_COST;
+    }
+    for (size_t y = 0; y < maze->height; y++) {
+        for (size_t x = 0; x < maze->width; x++) {
+            grid->cells[tiled_index(grid, x, y)] = maze->tiles[y][x];
+        }
+    }
+    return true;
+}
+
+void tiled_grid_destroy(struct tiled_grid *grid)
+{
+    assert(grid != NULL);
+    free(grid->cells);
+    grid->cells = NULL;
+}
+
+/*
+ * Same rule as col_alone_wall, evaluated block by block: each block is read
+ * once front to back while per-column counters accumulate across block rows.
+ */
+bool tiled_col_alone_wall(const struct tiled_grid *grid)
+{
+    assert(grid != NULL);
+    size_t *counter_hash = (size_t *) calloc(grid->width, sizeof(size_t));
+    size_t *counter_X = (size_t *) calloc(grid->width, sizeof(size_t));
+    if (counter_hash == NULL || counter_X == NULL) {
+        free(counter_hash);
+        free(counter_X);
+        return false;
+    }
+
+    size_t block_w = (size_t) 1 << grid->block_w_shift;
+    size_t block_h = (size_t) 1 << grid->block_h_shift;
+    for (size_t by = 0; by < grid->blocks_y; by++) {
+        size_t y_end = (by + 1) * block_h < grid->height ? (by + 1) * block_h : grid->height;
+        for (size_t bx = 0; bx < grid->blocks_x; bx++) {
+            size_t x_begin = bx * block_w;
+            size_t x_end = x_begin + block_w < grid->width ? x_begin + block_w : grid->width;
+            for (size_t y = by * block_h; y < y_end; y++) {
+                const struct tile *row = grid->cells + tiled_index(grid, x_begin, y);
+                for (size_t x = x_begin; x < x_end; x++) {
+                    counter_hash[x] += row[x - x_begin].value == '#';
+                    counter_X[x] += row[x - x_begin].value == 'X';
+                }
+            }
+        }
+    }
+
+    bool ok = true;
+    for (size_t x = 0; x < grid->width; x++) {
+        if (counter_hash[x] == 1 && counter_X[x] != 1) {
+            ok = false;
+            break;
+        }
+    }
+    free(counter_hash);
+    free(counter_X);
+    return ok;
+}
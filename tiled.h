@@ -0,0 +1,36 @@
+#ifndef TILED_H
+#define TILED_H
+
+#include "maze.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// default block is 64 x 64 tiles (8 KiB of struct tile), sized for L1/L2
+#define TILED_BLOCK_SHIFT 6
+
+struct tiled_grid
+{
+    size_t width;
+    size_t height;
+    unsigned block_w_shift;  // block width is 1 << block_w_shift tiles
+    unsigned block_h_shift;  // block height is 1 << block_h_shift tiles
+    size_t blocks_x;         // blocks per block row
+    size_t blocks_y;
+    struct tile *cells;      // blocks stored one after another in block-row order
+};
+
+bool tiled_grid_create(struct tiled_grid *grid, struct maze *maze, unsigned block_w_shift, unsigned block_h_shift);
+void tiled_grid_destroy(struct tiled_grid *grid);
+bool tiled_col_alone_wall(const struct tiled_grid *grid);
+
+// position of tile (x, y) inside grid->cells
+static inline size_t tiled_index(const struct tiled_grid *grid, size_t x, size_t y)
+{
+    size_t block = (y >> grid->block_h_shift) * grid->blocks_x + (x >> grid->block_w_shift);
+    size_t inner_x = x & (((size_t) 1 << grid->block_w_shift) - 1);
+    size_t inner_y = y & (((size_t) 1 << grid->block_h_shift) - 1);
+    return (block << (grid->block_w_shift + grid->block_h_shift)) + (inner_y << grid->block_w_shift) + inner_x;
+}
+
+#endif // TILED_H
@@ -0,0 +1,165 @@
+#include "validate.h"
+
+#include "stripes.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Parallel validation pipeline.
+ * The padded grid is split into horizontal stripes and every stripe does all
+ * of its row-local work in one job: the wall isolation scan and per-row
+ * '#'/'X' counts of is_valid, per-column '#'/'X' counters for col_alone_wall
+ * and pass one of the union-find labeling. Neighbour reads may cross into the
+ * next stripe but nothing there is written, so stripes need no locking.
+ * The merge step keeps the earliest failing row, stitches wall and open
+ * components across stripe borders and sums the column counters, which gives
+ * the same verdict as the sequential checks for any number of stripes.
+ */
+
+struct validate_job
+{
+    struct maze *maze;
+    struct components *components;
+    size_t y_begin;
+    size_t y_end;
+    uint32_t *column_walls;   // '#' per column inside the stripe
+    uint32_t *column_markers; // 'X' per column inside the stripe
+    size_t bad_row;           // y_end when every row of the stripe passed
+    bool isolated_wall;
+    size_t num_walls;
+    size_t wall_roots;
+    size_t open_roots;
+};
+
+static bool is_wall(struct maze *maze, size_t x, size_t y)
+{
+    return maze->tiles[y][x].value == '#';
+}
+
+// a '#' needs at least one '#' next to it, same rule as the is_valid scan
+static bool is_isolated(struct maze *maze, size_t x, size_t y)
+{
+    return !(x > 0 && is_wall(maze, x - 1, y))
+            && !(x + 1 < maze->width && is_wall(maze, x + 1, y))
+            && !(y > 0 && is_wall(maze, x, y - 1))
+            && !(y + 1 < maze->height && is_wall(maze, x, y + 1));
+}
+
+static void *scan_stripe(void *arg)
+{
+    struct validate_job *job = (struct validate_job *) arg;
+    struct maze *maze = job->maze;
+    job->bad_row = job->y_end;
+    job->isolated_wall = false;
+    job->num_walls = 0;
+
+    for (size_t y = job->y_begin; y < job->y_end; y++) {
+        const struct tile *row = maze->tiles[y];
+        size_t hash_count = 0;
+        size_t x_count = 0;
+        bool isolated = false;
+        for (size_t x = 0; x < maze->width; x++) {
+            if (row[x].value == '#') {
+                hash_count++;
+                job->column_walls[x]++;
+                isolated = isolated || is_isolated(maze, x, y);
+            } else if (row[x].value == 'X') {
+                x_count++;
+                job->column_markers[x]++;
+            }
+        }
+        job->num_walls += hash_count;
+        // only the first failure of the stripe matters, the merge keeps the earliest one
+        if (job->bad_row == job->y_end && (isolated || (hash_count == 1 && x_count != 1))) {
+            job->bad_row = y;
+            job->isolated_wall = isolated;
+        }
+    }
+
+    components_label_rows(job->components, maze, job->y_begin, job->y_end);
+    return NULL;
+}
+
+static void *flatten_stripe(void *arg)
+{
+    struct validate_job *job = (struct validate_job *) arg;
+    components_flatten_rows(job->components, job->y_begin, job->y_end, &job->wall_roots, &job->open_roots);
+    return NULL;
+}
+
+/*
+ * Runs the row scan, column counting and component labeling of the padded
+ * maze on up to 'threads' stripes and merges them into validation and
+ * components. Returns false on allocation failure or if the grid is too
+ * large for 32-bit labels.
+ */
+bool validate_stripes(struct validation *validation, struct components *components, struct maze *maze, size_t threads)
+{
+    assert(validation != NULL);
+    assert(components != NULL);
+    assert(maze != NULL);
+
+    if (!components_init(components, maze)) {
+        return false;
+    }
+    threads = stripes_count(threads, maze->height);
+    struct validate_job *jobs = (struct validate_job *) malloc(threads * sizeof(struct validate_job));
+    uint32_t *counters = (uint32_t *) calloc(threads * maze->width * 2, sizeof(uint32_t));
+    if (jobs == NULL || counters == NULL) {
+        free(jobs);
+        free(counters);
+        components_destroy(components);
+        return false;
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        jobs[i].maze = maze;
+        jobs[i].components = components;
+        jobs[i].y_begin = stripe_begin(maze->height, i, threads);
+        jobs[i].y_end = stripe_begin(maze->height, i + 1, threads);
+        jobs[i].column_walls = counters + i * maze->width * 2;
+        jobs[i].column_markers = jobs[i].column_walls + maze->width;
+    }
+    stripes_run(jobs, sizeof(struct validate_job), threads, scan_stripe);
+
+    // merge: earliest failing row and wall total
+    validation->bad_row = maze->height;
+    validation->isolated_wall = false;
+    validation->num_walls = 0;
+    for (size_t i = 0; i < threads; i++) {
+        validation->num_walls += jobs[i].num_walls;
+        if (validation->bad_row == maze->height && jobs[i].bad_row < jobs[i].y_end) {
+            validation->bad_row = jobs[i].bad_row;
+            validation->isolated_wall = jobs[i].isolated_wall;
+        }
+    }
+
+    // merge: components across stripe borders, then pass two in parallel
+    for (size_t i = 1; i < threads; i++) {
+        components_stitch_row(components, jobs[i].y_begin);
+    }
+    stripes_run(jobs, sizeof(struct validate_job), threads, flatten_stripe);
+    for (size_t i = 0; i < threads; i++) {
+        components->num_wall_components += jobs[i].wall_roots;
+        components->num_open_components += jobs[i].open_roots;
+    }
+    components_keep_doors(components, maze->entrance, maze->exit);
+
+    // merge: column counters
+    validation->alone_column = false;
+    for (size_t x = 0; x < maze->width && !validation->alone_column; x++) {
+        size_t walls = 0;
+        size_t markers = 0;
+        for (size_t i = 0; i < threads; i++) {
+            walls += jobs[i].column_walls[x];
+            markers += jobs[i].column_markers[x];
+        }
+        validation->alone_column = walls == 1 && markers != 1;
+    }
+
+    free(counters);
+    free(jobs);
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include "ccl.h"
+#include "maze.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Merged outcome of the per-stripe checks, in the terms of the sequential
+ * is_valid scan so it can report the same first failure.
+ */
+struct validation
+{
+    size_t bad_row;     // first row failing the wall scan, maze height when none does
+    bool isolated_wall; // bad_row holds a '#' without wall neighbours, otherwise it broke the row count rule
+    size_t num_walls;
+    bool alone_column;  // some column holds exactly one '#' but not exactly one 'X' (col_alone_wall)
+};
+
+bool validate_stripes(struct validation *validation, struct components *components, struct maze *maze, size_t threads);
+
+#endif // VALIDATE_H